@@ -0,0 +1,202 @@
+#include "leakguard/leak_logic.hpp"
+#include "leakguard/leak_logic_t.hpp"
+#include "leakguard/flow_rate_batch.hpp"
+#include "leakguard/fleet_replay.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+namespace {
+
+    void fillCriteria(lg::LeakLogic& logic, const int64_t count) {
+        for (int64_t i = 0; i < count; i++)
+            logic.emplaceCriterion<lg::TimeBasedFlowRateCriterion>(2.0f + static_cast<float>(i), 60 + i);
+    }
+
+    void applyCriteriaCounts(benchmark::internal::Benchmark* benchmark) {
+        benchmark->Arg(1)->Arg(5)->Arg(LEAK_LOGIC_MAX_CRITERIA);
+    }
+
+}
+
+static void BM_LeakLogicUpdate(benchmark::State& state) {
+    lg::LeakLogic logic;
+    fillCriteria(logic, state.range(0));
+    const lg::SensorState sensorState(3.0f, lg::ProbeMask());
+
+    for (auto _ : state) {
+        logic.update(sensorState, 1);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_LeakLogicUpdate)->Apply(applyCriteriaCounts);
+
+static void BM_LeakLogicGetAction(benchmark::State& state) {
+    lg::LeakLogic logic;
+    fillCriteria(logic, state.range(0));
+    logic.update(lg::SensorState(0.0f, lg::ProbeMask()), 1);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(logic.getAction());
+    }
+}
+BENCHMARK(BM_LeakLogicGetAction)->Apply(applyCriteriaCounts);
+
+static void BM_LeakLogicTick(benchmark::State& state) {
+    lg::LeakLogic logic;
+    fillCriteria(logic, state.range(0));
+    const lg::SensorState sensorState(3.0f, lg::ProbeMask());
+
+    for (auto _ : state) {
+        logic.update(sensorState, 1);
+        benchmark::DoNotOptimize(logic.getAction());
+    }
+}
+BENCHMARK(BM_LeakLogicTick)->Apply(applyCriteriaCounts);
+
+static void BM_LeakLogicTTick(benchmark::State& state) {
+    lg::LeakLogicT<lg::TimeBasedFlowRateCriterion, lg::ProbeLeakDetectionCriterion> logic;
+    for (int64_t i = 0; i < state.range(0); i++)
+        logic.emplaceCriterion<lg::TimeBasedFlowRateCriterion>(2.0f + static_cast<float>(i), 60 + i);
+    const lg::SensorState sensorState(3.0f, lg::ProbeMask());
+
+    for (auto _ : state) {
+        logic.update(sensorState, 1);
+        benchmark::DoNotOptimize(logic.getAction());
+    }
+}
+BENCHMARK(BM_LeakLogicTTick)->Apply(applyCriteriaCounts);
+
+static void BM_LeakLogicSerialize(benchmark::State& state) {
+    lg::LeakLogic logic;
+    fillCriteria(logic, state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(logic.serialize());
+    }
+}
+BENCHMARK(BM_LeakLogicSerialize)->Apply(applyCriteriaCounts);
+
+static void BM_LeakLogicLoadFromString(benchmark::State& state) {
+    lg::LeakLogic source;
+    fillCriteria(source, state.range(0));
+    const auto serialized = source.serialize();
+    lg::LeakLogic logic;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(logic.loadFromString(serialized));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(serialized.GetLength()));
+}
+BENCHMARK(BM_LeakLogicLoadFromString)->Apply(applyCriteriaCounts);
+
+static void BM_LeakLogicLoadFromBinary(benchmark::State& state) {
+    lg::LeakLogic source;
+    fillCriteria(source, state.range(0));
+    uint8_t buffer[LEAK_LOGIC_MAX_SERIALIZE_LENGTH];
+    const size_t length = source.serializeBinary(buffer, sizeof(buffer));
+    lg::LeakLogic logic;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(logic.loadFromBinary(buffer, length));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(length));
+}
+BENCHMARK(BM_LeakLogicLoadFromBinary)->Apply(applyCriteriaCounts);
+
+static void BM_ProbeScan(benchmark::State& state) {
+    lg::ProbeLeakDetectionCriterion criterion;
+    lg::ProbeMask probeStates;
+    probeStates.set(static_cast<size_t>(state.range(0)));
+    const lg::SensorState sensorState(0.0f, probeStates);
+
+    for (auto _ : state) {
+        criterion.update(sensorState, 1);
+        benchmark::DoNotOptimize(criterion.getAction());
+    }
+}
+BENCHMARK(BM_ProbeScan)->Arg(0)->Arg(255);
+
+static void BM_FlowRateBatchUpdate(benchmark::State& state) {
+    const auto households = static_cast<size_t>(state.range(0));
+    const auto kernelType = static_cast<lg::FlowRateKernelType>(state.range(1));
+    if (!lg::isFlowRateKernelSupported(kernelType)) {
+        state.SkipWithError("Kernel not supported on this CPU");
+        return;
+    }
+
+    lg::FlowRateBatch batch(households, lg::getFlowRateKernel(kernelType));
+    batch.addRule(2.0f, 60);
+    batch.addRule(8.0f, 20);
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> flowDistribution(0.0f, 10.0f);
+    std::vector<float> flowRates(households);
+    for (auto& flowRate : flowRates)
+        flowRate = flowDistribution(random);
+
+    for (auto _ : state) {
+        batch.update(flowRates.data(), 1);
+        benchmark::DoNotOptimize(batch.getActionMask().data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(households));
+}
+BENCHMARK(BM_FlowRateBatchUpdate)->ArgsProduct({
+    { 1024, 200000 },
+    {
+        static_cast<int64_t>(lg::FlowRateKernelType::SCALAR),
+        static_cast<int64_t>(lg::FlowRateKernelType::SSE42),
+        static_cast<int64_t>(lg::FlowRateKernelType::AVX2)
+    }
+});
+
+static void BM_FleetOfLeakLogics(benchmark::State& state) {
+    const auto households = static_cast<size_t>(state.range(0));
+    std::vector<lg::LeakLogic> fleet(households);
+    for (auto& logic : fleet) {
+        logic.emplaceCriterion<lg::TimeBasedFlowRateCriterion>(2.0f, 60);
+        logic.emplaceCriterion<lg::TimeBasedFlowRateCriterion>(8.0f, 20);
+    }
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> flowDistribution(0.0f, 10.0f);
+    std::vector<float> flowRates(households);
+    for (auto& flowRate : flowRates)
+        flowRate = flowDistribution(random);
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < households; i++)
+            fleet[i].onFlowSample(flowRates[i], 1);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(households));
+}
+BENCHMARK(BM_FleetOfLeakLogics)->Arg(1024)->Arg(200000);
+
+static void BM_FleetReplay(benchmark::State& state) {
+    const auto threadCount = static_cast<size_t>(state.range(0));
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> flowDistribution(0.0f, 4.0f);
+
+    // Heavily skewed sample counts, as in real fleets
+    std::vector<std::vector<lg::ReplaySample>> telemetry(2000);
+    size_t totalSamples = 0;
+    for (size_t household = 0; household < telemetry.size(); household++) {
+        const size_t sampleCount = household % 100 == 0 ? 100000 : 1000;
+        telemetry[household].reserve(sampleCount);
+        for (size_t i = 0; i < sampleCount; i++)
+            telemetry[household].push_back(lg::ReplaySample { static_cast<time_t>(i * 10), flowDistribution(random) });
+        totalSamples += sampleCount;
+    }
+
+    for (auto _ : state) {
+        lg::FleetReplay fleet;
+        for (const auto& samples : telemetry)
+            fleet.addHousehold("T,200,60,|T,350,20,|", samples);
+        benchmark::DoNotOptimize(fleet.run(threadCount));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(totalSamples));
+}
+BENCHMARK(BM_FleetReplay)->RangeMultiplier(2)->Range(1, 64)->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -0,0 +1,357 @@
+#ifndef BINARY_CONFIG_HPP
+#define BINARY_CONFIG_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#define LEAK_LOGIC_BINARY_VERSION 1
+
+namespace lg {
+
+    /**
+     * @brief CRC-32 (IEEE 802.3) of a byte buffer, using a 16-entry table to keep flash usage low.
+     *
+     * @param crc Result of a previous call, to checksum a buffer in pieces.
+     */
+    inline uint32_t crc32(const uint8_t* data, const size_t length, uint32_t crc = 0) {
+        static constexpr uint32_t table[16] = {
+            0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+            0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+        };
+
+        crc = ~crc;
+        for (size_t i = 0; i < length; i++) {
+            crc = table[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+            crc = table[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+        }
+        return ~crc;
+    }
+
+    /**
+     * @brief Writes little-endian fields into a fixed buffer. Overflow is sticky and checked once at the end.
+     */
+    class BinaryWriter {
+    public:
+        BinaryWriter(uint8_t* buffer, const size_t capacity)
+            : buffer(buffer), capacity(capacity) {}
+
+        void writeU8(const uint8_t value) {
+            if (length >= capacity) {
+                overflow = true;
+                return;
+            }
+            buffer[length++] = value;
+        }
+
+        void writeU16(const uint16_t value) {
+            writeU8(value & 0xFF);
+            writeU8(value >> 8);
+        }
+
+        void writeU32(const uint32_t value) {
+            writeU16(value & 0xFFFF);
+            writeU16(value >> 16);
+        }
+
+        void writeI32(const int32_t value) { writeU32(static_cast<uint32_t>(value)); }
+
+        void writeF32(const float value) { writeU32(std::bit_cast<uint32_t>(value)); }
+
+        /**
+         * @brief Reserve a single byte to be filled in later with patchU8().
+         */
+        size_t reserveU8() {
+            writeU8(0);
+            return length - 1;
+        }
+
+        void patchU8(const size_t offset, const uint8_t value) {
+            if (offset < length)
+                buffer[offset] = value;
+        }
+
+        /**
+         * @brief Start a record: a type tag followed by the payload length, filled in by endRecord().
+         */
+        void beginRecord(const char type) {
+            writeU8(static_cast<uint8_t>(type));
+            recordStart = length;
+            writeU8(0);
+        }
+
+        void endRecord() {
+            if (!overflow)
+                buffer[recordStart] = static_cast<uint8_t>(length - recordStart - 1);
+        }
+
+        [[nodiscard]] size_t getLength() const { return length; }
+        [[nodiscard]] bool isOverflow() const { return overflow; }
+        [[nodiscard]] uint8_t* getBuffer() const { return buffer; }
+
+    private:
+        uint8_t* buffer;
+        size_t capacity;
+        size_t length = 0;
+        size_t recordStart = 0;
+        bool overflow = false;
+    };
+
+    /**
+     * @brief Reads little-endian fields from a buffer in place. Reading past the end yields zeros and
+     * clears isValid().
+     */
+    class BinaryReader {
+    public:
+        BinaryReader(const uint8_t* data, const size_t size)
+            : data(data), size(size) {}
+
+        uint8_t readU8() {
+            if (offset >= size) {
+                valid = false;
+                return 0;
+            }
+            return data[offset++];
+        }
+
+        uint16_t readU16() {
+            const uint16_t low = readU8();
+            return low | static_cast<uint16_t>(readU8() << 8);
+        }
+
+        uint32_t readU32() {
+            const uint32_t low = readU16();
+            return low | static_cast<uint32_t>(readU16()) << 16;
+        }
+
+        int32_t readI32() { return static_cast<int32_t>(readU32()); }
+
+        float readF32() { return std::bit_cast<float>(readU32()); }
+
+        /**
+         * @brief Skip bytes without reading them.
+         */
+        void skip(const size_t count) {
+            if (count > size - offset) {
+                valid = false;
+                offset = size;
+                return;
+            }
+            offset += count;
+        }
+
+        [[nodiscard]] size_t getRemaining() const { return size - offset; }
+        [[nodiscard]] const uint8_t* getPosition() const { return data + offset; }
+
+        [[nodiscard]] size_t getOffset() const { return offset; }
+        [[nodiscard]] bool isValid() const { return valid; }
+
+    private:
+        const uint8_t* data;
+        size_t size;
+        size_t offset = 0;
+        bool valid = true;
+    };
+
+    /**
+     * @brief Read-only view of a binary criteria configuration, e.g. directly in memory-mapped flash.
+     *
+     * Layout (all fields little-endian):
+     *  - magic "LG", version (u8), criterion count (u8),
+     *  - per criterion: type tag (u8, same letter as the text format), payload length (u8), payload,
+     *  - CRC-32 (u32) of everything before it.
+     */
+    class BinaryConfigView {
+    public:
+        static constexpr size_t HEADER_SIZE = 4;
+        static constexpr size_t CRC_SIZE = 4;
+
+        /**
+         * @brief A single criterion record, pointing into the viewed buffer.
+         */
+        struct Record {
+            char type;
+            const uint8_t* payload;
+            uint8_t length;
+        };
+
+        class Iterator {
+        public:
+            Iterator(const uint8_t* position, const size_t remaining)
+                : position(position), remaining(remaining) {}
+
+            Record operator*() const {
+                return Record { static_cast<char>(position[0]), position + 2, position[1] };
+            }
+
+            Iterator& operator++() {
+                position += 2 + position[1];
+                remaining--;
+                return *this;
+            }
+
+            bool operator!=(const Iterator& other) const { return remaining != other.remaining; }
+
+        private:
+            const uint8_t* position;
+            size_t remaining;
+        };
+
+        BinaryConfigView(const uint8_t* data, const size_t size)
+            : data(data), size(size) {}
+
+        /**
+         * @brief Check the header, record framing and CRC. Other methods require a valid view.
+         */
+        [[nodiscard]] bool isValid() const {
+            if (size < HEADER_SIZE + CRC_SIZE)
+                return false;
+            if (data[0] != 'L' || data[1] != 'G' || data[2] != LEAK_LOGIC_BINARY_VERSION)
+                return false;
+
+            size_t offset = HEADER_SIZE;
+            for (size_t i = 0; i < getCount(); i++) {
+                if (offset + 2 > size - CRC_SIZE)
+                    return false;
+                offset += 2 + data[offset + 1];
+            }
+            if (offset != size - CRC_SIZE)
+                return false;
+
+            BinaryReader crcReader(data + offset, CRC_SIZE);
+            return crcReader.readU32() == crc32(data, offset);
+        }
+
+        [[nodiscard]] size_t getCount() const { return data[3]; }
+        [[nodiscard]] uint32_t getCrc() const {
+            BinaryReader crcReader(data + size - CRC_SIZE, CRC_SIZE);
+            return crcReader.readU32();
+        }
+
+        [[nodiscard]] Iterator begin() const { return Iterator(data + HEADER_SIZE, getCount()); }
+        [[nodiscard]] Iterator end() const { return Iterator(nullptr, 0); }
+
+    private:
+        const uint8_t* data;
+        size_t size;
+    };
+
+    enum class PatchOperation : uint8_t {
+        ADD = 'A',
+        REMOVE = 'R',
+        REPLACE = 'S'
+    };
+
+    /**
+     * @brief Read-only view of a binary configuration patch, changing single criteria in place.
+     *
+     * Layout (all fields little-endian):
+     *  - magic "LP", version (u8), operation count (u8), hash of the configuration the patch applies to (u32),
+     *  - per operation: operation (u8, see PatchOperation), criterion index (u8), and for ADD and REPLACE
+     *    a criterion record as in BinaryConfigView,
+     *  - CRC-32 (u32) of everything before it.
+     *
+     * Operations apply in order, so each index refers to the criteria as left by the previous operation.
+     */
+    class BinaryPatchView {
+    public:
+        static constexpr size_t HEADER_SIZE = 8;
+        static constexpr size_t CRC_SIZE = 4;
+
+        struct Operation {
+            PatchOperation operation;
+            uint8_t index;
+            /**
+             * @brief The new criterion, for ADD and REPLACE.
+             */
+            BinaryConfigView::Record record;
+        };
+
+        class Iterator {
+        public:
+            Iterator(const uint8_t* position, const size_t remaining)
+                : position(position), remaining(remaining) {}
+
+            Operation operator*() const {
+                const auto operation = static_cast<PatchOperation>(position[0]);
+                if (!hasRecord(operation))
+                    return Operation { operation, position[1], { 0, nullptr, 0 } };
+
+                return Operation { operation, position[1],
+                    { static_cast<char>(position[2]), position + 4, position[3] } };
+            }
+
+            Iterator& operator++() {
+                position += getOperationSize(position);
+                remaining--;
+                return *this;
+            }
+
+            bool operator!=(const Iterator& other) const { return remaining != other.remaining; }
+
+        private:
+            const uint8_t* position;
+            size_t remaining;
+        };
+
+        BinaryPatchView(const uint8_t* data, const size_t size)
+            : data(data), size(size) {}
+
+        /**
+         * @brief Check the header, operation framing and CRC. Other methods require a valid view.
+         */
+        [[nodiscard]] bool isValid() const {
+            if (size < HEADER_SIZE + CRC_SIZE)
+                return false;
+            if (data[0] != 'L' || data[1] != 'P' || data[2] != LEAK_LOGIC_BINARY_VERSION)
+                return false;
+
+            size_t offset = HEADER_SIZE;
+            for (size_t i = 0; i < getCount(); i++) {
+                if (offset + 2 > size - CRC_SIZE)
+                    return false;
+
+                const auto operation = static_cast<PatchOperation>(data[offset]);
+                if (operation != PatchOperation::ADD && operation != PatchOperation::REMOVE
+                    && operation != PatchOperation::REPLACE)
+                    return false;
+                if (hasRecord(operation) && offset + 4 > size - CRC_SIZE)
+                    return false;
+
+                offset += getOperationSize(data + offset);
+            }
+            if (offset != size - CRC_SIZE)
+                return false;
+
+            BinaryReader crcReader(data + offset, CRC_SIZE);
+            return crcReader.readU32() == crc32(data, offset);
+        }
+
+        [[nodiscard]] size_t getCount() const { return data[3]; }
+
+        /**
+         * @brief Hash of the configuration the patch was made for, see LeakLogic::getConfigHash().
+         */
+        [[nodiscard]] uint32_t getBaseHash() const {
+            BinaryReader reader(data + 4, 4);
+            return reader.readU32();
+        }
+
+        [[nodiscard]] Iterator begin() const { return Iterator(data + HEADER_SIZE, getCount()); }
+        [[nodiscard]] Iterator end() const { return Iterator(nullptr, 0); }
+
+    private:
+        static bool hasRecord(const PatchOperation operation) {
+            return operation != PatchOperation::REMOVE;
+        }
+
+        static size_t getOperationSize(const uint8_t* operation) {
+            return hasRecord(static_cast<PatchOperation>(operation[0])) ? 4 + operation[3] : 2;
+        }
+
+        const uint8_t* data;
+        size_t size;
+    };
+
+}
+#endif //BINARY_CONFIG_HPP
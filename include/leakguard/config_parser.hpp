@@ -0,0 +1,222 @@
+#ifndef CONFIG_PARSER_HPP
+#define CONFIG_PARSER_HPP
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#define LEAK_LOGIC_MAX_CRITERION_FIELDS 4
+#define LEAK_LOGIC_MAX_NUMBER_LENGTH 12
+
+namespace lg {
+
+    /**
+     * @brief Text configuration parse error.
+     */
+    enum class ParseError {
+        NONE,
+        UNEXPECTED_CHARACTER,
+        INVALID_NUMBER,
+        TOO_MANY_FIELDS,
+        INVALID_RECORD,
+        INCOMPLETE_RECORD
+    };
+
+    /**
+     * @brief Result of parsing, with the byte offset (from the start of the whole input) of the error, if any.
+     */
+    struct ParseResult {
+        ParseError error = ParseError::NONE;
+        size_t offset = 0;
+
+        [[nodiscard]] bool isOk() const { return error == ParseError::NONE; }
+        explicit operator bool() const { return isOk(); }
+    };
+
+    /**
+     * @brief A single criterion record of the text configuration format: a type tag and its integer fields.
+     */
+    struct ParsedCriterion {
+        char type = 0;
+        uint8_t fieldCount = 0;
+        int32_t fields[LEAK_LOGIC_MAX_CRITERION_FIELDS] {};
+    };
+
+    /**
+     * @brief Single-pass parser for the text configuration format, e.g. "T,200,60,|P,|".
+     *
+     * Records are separated by '|', fields by ','. Input may be fed in arbitrary chunks; numbers are
+     * parsed in place with std::from_chars and only a number split between two chunks is copied.
+     */
+    class ConfigParser {
+    public:
+        /**
+         * @brief Parse the next chunk of input.
+         *
+         * @param onRecord Called with each complete record, returns whether the record was accepted.
+         * @return The first error. Once an error occurs, further input is ignored.
+         */
+        template <typename Handler>
+        ParseResult feed(const std::string_view chunk, Handler&& onRecord) {
+            size_t tokenStart = 0;
+
+            for (size_t i = 0; i < chunk.size() && result.isOk(); i++) {
+                const char c = chunk[i];
+                const size_t offset = consumed + i;
+
+                switch (state) {
+                    case RECORD_START:
+                        if (!isTypeTag(c)) {
+                            fail(ParseError::UNEXPECTED_CHARACTER, offset);
+                            break;
+                        }
+                        record = ParsedCriterion();
+                        record.type = c;
+                        state = AFTER_TYPE;
+                    break;
+                    case AFTER_TYPE:
+                        if (c == ',')
+                            state = FIELD_START;
+                        else if (c == '|')
+                            endRecord(onRecord, offset);
+                        else
+                            fail(ParseError::UNEXPECTED_CHARACTER, offset);
+                    break;
+                    case FIELD_START:
+                        if (c == '|') {
+                            endRecord(onRecord, offset);
+                        }
+                        else if (isNumberCharacter(c)) {
+                            tokenStart = i;
+                            tokenOffset = offset;
+                            carryLength = 0;
+                            state = FIELD;
+                        }
+                        else {
+                            fail(ParseError::UNEXPECTED_CHARACTER, offset);
+                        }
+                    break;
+                    case FIELD:
+                        if (isNumberCharacter(c))
+                            break;
+                        if (c != ',' && c != '|') {
+                            fail(ParseError::UNEXPECTED_CHARACTER, offset);
+                            break;
+                        }
+                        if (!endField(chunk.substr(tokenStart, i - tokenStart)))
+                            break;
+                        if (c == '|')
+                            endRecord(onRecord, offset);
+                        else
+                            state = FIELD_START;
+                    break;
+                }
+            }
+
+            if (result.isOk() && state == FIELD)
+                carry(chunk.substr(tokenStart));
+
+            consumed += chunk.size();
+            return result;
+        }
+
+        /**
+         * @brief Signal the end of input.
+         *
+         * @return The first error, including an unterminated last record.
+         */
+        ParseResult finish() {
+            if (result.isOk() && state != RECORD_START)
+                fail(ParseError::INCOMPLETE_RECORD, consumed);
+            return result;
+        }
+
+        /**
+         * @brief Prepare the parser for new input.
+         */
+        void reset() { *this = ConfigParser(); }
+
+        /**
+         * @brief Parse a single record, with or without the terminating '|'.
+         */
+        static ParseResult parseRecord(const std::string_view text, ParsedCriterion& parsed) {
+            ConfigParser parser;
+            bool found = false;
+            const auto onRecord = [&](const ParsedCriterion& record) {
+                if (found)
+                    return false;
+                parsed = record;
+                found = true;
+                return true;
+            };
+
+            parser.feed(text, onRecord);
+            if (!text.empty() && text.back() != '|')
+                parser.feed("|", onRecord);
+            return parser.finish();
+        }
+
+    private:
+        enum State { RECORD_START, AFTER_TYPE, FIELD_START, FIELD };
+
+        static bool isTypeTag(const char c) { return c >= 'A' && c <= 'Z'; }
+        static bool isNumberCharacter(const char c) { return (c >= '0' && c <= '9') || c == '-'; }
+
+        void fail(const ParseError error, const size_t offset) {
+            result.error = error;
+            result.offset = offset;
+        }
+
+        void carry(const std::string_view part) {
+            if (carryLength + part.size() > LEAK_LOGIC_MAX_NUMBER_LENGTH) {
+                fail(ParseError::INVALID_NUMBER, tokenOffset);
+                return;
+            }
+            for (const char c : part)
+                carryBuffer[carryLength++] = c;
+        }
+
+        bool endField(std::string_view token) {
+            if (carryLength > 0) {
+                carry(token);
+                if (!result.isOk())
+                    return false;
+                token = std::string_view(carryBuffer, carryLength);
+                carryLength = 0;
+            }
+
+            if (record.fieldCount >= LEAK_LOGIC_MAX_CRITERION_FIELDS) {
+                fail(ParseError::TOO_MANY_FIELDS, tokenOffset);
+                return false;
+            }
+
+            int32_t value = 0;
+            const auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), value);
+            if (error != std::errc() || end != token.data() + token.size()) {
+                fail(ParseError::INVALID_NUMBER, tokenOffset);
+                return false;
+            }
+
+            record.fields[record.fieldCount++] = value;
+            return true;
+        }
+
+        template <typename Handler>
+        void endRecord(Handler& onRecord, const size_t offset) {
+            if (!onRecord(static_cast<const ParsedCriterion&>(record)))
+                fail(ParseError::INVALID_RECORD, offset);
+            state = RECORD_START;
+        }
+
+        State state = RECORD_START;
+        ParsedCriterion record;
+        ParseResult result;
+        size_t consumed = 0;
+        size_t tokenOffset = 0;
+        char carryBuffer[LEAK_LOGIC_MAX_NUMBER_LENGTH] {};
+        size_t carryLength = 0;
+    };
+
+}
+#endif //CONFIG_PARSER_HPP
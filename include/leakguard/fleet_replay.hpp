@@ -0,0 +1,185 @@
+#ifndef FLEET_REPLAY_HPP
+#define FLEET_REPLAY_HPP
+
+#include "leakguard/leak_logic.hpp"
+#include "leakguard/work_stealing_pool.hpp"
+
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace lg {
+
+    /**
+     * @brief A single telemetry sample of a household.
+     */
+    struct ReplaySample {
+        /**
+         * @brief Time of the sample, in seconds.
+         */
+        time_t timestamp;
+
+        /**
+         * @brief Flow rate at the time of the sample, in liters per minute.
+         */
+        float flowRate;
+
+        /**
+         * @brief Probe that changed state at the time of the sample, or -1 if none did.
+         */
+        int16_t probeId = -1;
+
+        /**
+         * @brief New state of the probe. Valid only if probeId is not -1.
+         */
+        bool probeWet = false;
+    };
+
+    /**
+     * @brief A change of the action determined by a household's leak logic during replay.
+     */
+    struct ReplayEvent {
+        size_t household;
+        time_t timestamp;
+        LeakPreventionAction action;
+    };
+
+    /**
+     * @brief Feeds the samples of one household into its leak logic and records action changes.
+     */
+    class HouseholdReplayer {
+    public:
+        HouseholdReplayer(LeakLogic& logic, const size_t household, std::vector<ReplayEvent>& events)
+            : logic(logic), household(household), events(events), lastAction(logic.getAction()) {}
+
+        void feed(const ReplaySample& sample) {
+            if (sample.probeId >= 0)
+                logic.onProbeChanged(static_cast<uint8_t>(sample.probeId), sample.probeWet);
+
+            logic.onFlowSample(flowRateFromLitersPerMinute(sample.flowRate), started ? sample.timestamp - lastTimestamp : 0);
+            lastTimestamp = sample.timestamp;
+            started = true;
+
+            const LeakPreventionAction action = logic.getAction();
+            if (action != lastAction) {
+                events.push_back(ReplayEvent { household, sample.timestamp, action });
+                lastAction = action;
+            }
+        }
+
+    private:
+        LeakLogic& logic;
+        size_t household;
+        std::vector<ReplayEvent>& events;
+        LeakPreventionAction lastAction;
+        time_t lastTimestamp = 0;
+        bool started = false;
+    };
+
+    /**
+     * @brief Produces the samples of one household by calling HouseholdReplayer::feed for each of them.
+     */
+    using ReplaySource = std::function<void(HouseholdReplayer&)>;
+
+    /**
+     * @brief Replays telemetry of many households through their own LeakLogic instances in parallel.
+     *
+     * Households are scheduled on a WorkStealingPool weighted by their sample count. The resulting
+     * events do not depend on the number of threads or on scheduling: they are ordered by household
+     * index, then by time.
+     */
+    class FleetReplay {
+    public:
+        /**
+         * @brief Register a household.
+         *
+         * @param configuration Criteria in the text configuration format.
+         * @param samples Telemetry ordered by time. Must outlive run().
+         * @return Index of the household, or -1 if the configuration could not be parsed.
+         */
+        ptrdiff_t addHousehold(const StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH>& configuration,
+                               const std::span<const ReplaySample> samples) {
+            return addHousehold(configuration, [samples](HouseholdReplayer& replayer) {
+                for (const ReplaySample& sample : samples)
+                    replayer.feed(sample);
+            }, samples.size());
+        }
+
+        /**
+         * @brief Register a household whose samples are produced on demand, e.g. decoded from a file.
+         *
+         * @param configuration Criteria in the text configuration format.
+         * @param source Produces the telemetry ordered by time. Must stay valid until run().
+         * @param sampleCount Number of samples, used to balance the load.
+         * @return Index of the household, or -1 if the configuration could not be parsed.
+         */
+        ptrdiff_t addHousehold(const StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH>& configuration,
+                               ReplaySource source, const size_t sampleCount) {
+            auto logic = std::make_unique<LeakLogic>();
+            if (!logic->loadFromString(configuration))
+                return -1;
+
+            households.push_back(Household { std::move(logic), std::move(source), sampleCount, {} });
+            return static_cast<ptrdiff_t>(households.size() - 1);
+        }
+
+        [[nodiscard]] size_t getHouseholdCount() const { return households.size(); }
+
+        /**
+         * @brief The leak logic of a household, in its state after the last run().
+         */
+        [[nodiscard]] LeakLogic& getLogic(const size_t household) { return *households[household].logic; }
+
+        /**
+         * @brief Replay all households.
+         *
+         * @param threadCount Number of worker threads, all hardware threads if 0.
+         * @return Action changes of all households, ordered by household, then by time.
+         */
+        std::vector<ReplayEvent> run(const size_t threadCount = 0) {
+            std::vector<size_t> weights(households.size());
+            for (size_t i = 0; i < households.size(); i++)
+                weights[i] = households[i].sampleCount;
+
+            WorkStealingPool pool(threadCount);
+            pool.run(weights, [this](const size_t household, size_t) {
+                replayHousehold(household);
+            });
+
+            size_t eventCount = 0;
+            for (const auto& household : households)
+                eventCount += household.events.size();
+
+            std::vector<ReplayEvent> events;
+            events.reserve(eventCount);
+            for (auto& household : households) {
+                events.insert(events.end(), household.events.begin(), household.events.end());
+                household.events.clear();
+                household.events.shrink_to_fit();
+            }
+
+            return events;
+        }
+
+    private:
+        struct Household {
+            std::unique_ptr<LeakLogic> logic;
+            ReplaySource source;
+            size_t sampleCount;
+            std::vector<ReplayEvent> events;
+        };
+
+        void replayHousehold(const size_t index) {
+            Household& household = households[index];
+            HouseholdReplayer replayer(*household.logic, index, household.events);
+            household.source(replayer);
+        }
+
+        std::vector<Household> households;
+    };
+
+}
+#endif //FLEET_REPLAY_HPP
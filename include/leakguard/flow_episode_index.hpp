@@ -0,0 +1,147 @@
+#ifndef FLOW_EPISODE_INDEX_HPP
+#define FLOW_EPISODE_INDEX_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace lg {
+
+    /**
+     * @brief A maximal run of samples whose flow rate is at least minFlowRate.
+     */
+    struct FlowEpisode {
+        /**
+         * @brief Index of the first sample of the run.
+         */
+        uint32_t start;
+
+        /**
+         * @brief Number of samples in the run.
+         */
+        uint32_t length;
+
+        /**
+         * @brief Lowest flow rate within the run, in liters per minute.
+         */
+        float minFlowRate;
+    };
+
+    /**
+     * @brief Index of the flow episodes of a series sampled at a fixed period, answering what-if
+     * questions about TimeBasedFlowRateCriterion parameters without the raw samples.
+     *
+     * For every distinct flow level, the index keeps each maximal run of samples at or above it.
+     * A criterion with threshold X accumulates time exactly over the runs whose minimum is at least X,
+     * so the earliest such run long enough for the duration tells whether and when it trips. Runs are
+     * nested like a Cartesian tree, so there are at most as many episodes as samples - in practice far
+     * fewer, as quantized flow rates repeat.
+     */
+    class FlowEpisodeIndex {
+    public:
+        FlowEpisodeIndex() = default;
+
+        /**
+         * @brief Build the index of a series.
+         *
+         * Sample i is taken at startTime + i * samplePeriod, and stands for the flow rate during the
+         * samplePeriod seconds before it (i.e. it is fed to update() with elapsedTime = samplePeriod).
+         *
+         * @param flowRates Flow rate of each sample, in liters per minute.
+         * @param samplePeriod Time between samples, in seconds.
+         * @param startTime Time of the first sample, in seconds.
+         */
+        FlowEpisodeIndex(const std::span<const float> flowRates, const time_t samplePeriod, const time_t startTime = 0)
+            : samplePeriod(samplePeriod), startTime(startTime), sampleCount(flowRates.size()) {
+            const size_t count = flowRates.size();
+            std::vector<float> levels(flowRates.begin(), flowRates.end());
+            for (float& level : levels) {
+                // NaN never reaches any threshold
+                if (std::isnan(level))
+                    level = -std::numeric_limits<float>::infinity();
+            }
+
+            // Bounds of the run around each sample: previous/next strictly lower sample
+            std::vector<ptrdiff_t> previousLower(count), previousLowerOrEqual(count), nextLower(count);
+            std::vector<ptrdiff_t> stack;
+            for (size_t i = 0; i < count; i++) {
+                while (!stack.empty() && levels[stack.back()] >= levels[i])
+                    stack.pop_back();
+                previousLower[i] = stack.empty() ? -1 : stack.back();
+                stack.push_back(static_cast<ptrdiff_t>(i));
+            }
+            stack.clear();
+            for (size_t i = 0; i < count; i++) {
+                while (!stack.empty() && levels[stack.back()] > levels[i])
+                    stack.pop_back();
+                previousLowerOrEqual[i] = stack.empty() ? -1 : stack.back();
+                stack.push_back(static_cast<ptrdiff_t>(i));
+            }
+            stack.clear();
+            for (size_t i = count; i-- > 0;) {
+                while (!stack.empty() && levels[stack.back()] >= levels[i])
+                    stack.pop_back();
+                nextLower[i] = stack.empty() ? static_cast<ptrdiff_t>(count) : stack.back();
+                stack.push_back(static_cast<ptrdiff_t>(i));
+            }
+
+            for (size_t i = 0; i < count; i++) {
+                // An equal sample earlier in the same run already produced this episode
+                if (previousLowerOrEqual[i] != previousLower[i])
+                    continue;
+
+                const auto start = static_cast<uint32_t>(previousLower[i] + 1);
+                episodes.push_back(FlowEpisode { start, static_cast<uint32_t>(nextLower[i]) - start, levels[i] });
+            }
+
+            std::sort(episodes.begin(), episodes.end(), [](const FlowEpisode& a, const FlowEpisode& b) {
+                return a.start != b.start ? a.start < b.start : a.length > b.length;
+            });
+        }
+
+        /**
+         * @brief When a TimeBasedFlowRateCriterion with the given parameters would have tripped first.
+         *
+         * @param rateThreshold Flow rate threshold, in liters per minute.
+         * @param minDuration Minimum duration for exceeded flow rate, in seconds.
+         * @return Time of the sample at which it trips, or nullopt if it never trips.
+         */
+        [[nodiscard]] std::optional<time_t> query(const float rateThreshold, const time_t minDuration) const {
+            const uint64_t samplesNeeded = requiredSamples(minDuration);
+
+            for (const FlowEpisode& episode : episodes) {
+                if (episode.minFlowRate >= rateThreshold && episode.length >= samplesNeeded)
+                    return startTime + static_cast<time_t>(episode.start + samplesNeeded - 1) * samplePeriod;
+            }
+            return std::nullopt;
+        }
+
+        [[nodiscard]] std::span<const FlowEpisode> getEpisodes() const { return episodes; }
+        [[nodiscard]] size_t getSampleCount() const { return sampleCount; }
+        [[nodiscard]] time_t getSamplePeriod() const { return samplePeriod; }
+
+    private:
+        /**
+         * Number of consecutive samples needed to accumulate minDuration (at least one, as time only
+         * accumulates while the flow rate is reached).
+         */
+        [[nodiscard]] uint64_t requiredSamples(const time_t minDuration) const {
+            if (minDuration <= 0 || samplePeriod <= 0)
+                return minDuration <= 0 ? 1 : std::numeric_limits<uint64_t>::max();
+
+            return std::max<uint64_t>(1, (static_cast<uint64_t>(minDuration) + samplePeriod - 1) / samplePeriod);
+        }
+
+        std::vector<FlowEpisode> episodes;
+        time_t samplePeriod = 0;
+        time_t startTime = 0;
+        size_t sampleCount = 0;
+    };
+
+}
+#endif //FLOW_EPISODE_INDEX_HPP
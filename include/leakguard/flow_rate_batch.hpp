@@ -0,0 +1,121 @@
+#ifndef FLOW_RATE_BATCH_HPP
+#define FLOW_RATE_BATCH_HPP
+
+#include "leakguard/leak_logic.hpp"
+#include "leakguard/flow_rate_kernel.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+namespace lg {
+
+    /**
+     * @brief Evaluates a set of TimeBasedFlowRateCriterion rules for many households at once.
+     *
+     * Parameters and runtime state are kept in structure-of-arrays layout, one lane per
+     * (rule, household) pair. Lanes of the same rule are contiguous and indexed like the
+     * flow rate array passed to update(), so each rule is a single streaming pass.
+     *
+     * Intended for host-side fleet processing - storage is allocated on the heap.
+     */
+    class FlowRateBatch {
+    public:
+        /**
+         * @param householdCount Number of households evaluated by each update.
+         * @param kernel Kernel implementation, the fastest one supported by the CPU by default.
+         */
+        explicit FlowRateBatch(const size_t householdCount, const FlowRateKernel kernel = getFlowRateKernel())
+            : householdCount(householdCount),
+              kernel(kernel),
+              ruleMask((householdCount + 63) / 64),
+              actionMask((householdCount + 63) / 64) {}
+
+        [[nodiscard]] size_t getHouseholdCount() const { return householdCount; }
+        [[nodiscard]] size_t getRuleCount() const { return ruleCount; }
+
+        /**
+         * @brief Add a rule applied to every household.
+         *
+         * @param rateThreshold Flow rate threshold, in liters per minute.
+         * @param minDuration Minimum duration for exceeded flow rate, in seconds.
+         * @return Index of the new rule.
+         */
+        size_t addRule(const float rateThreshold, const time_t minDuration) {
+            rateThresholds.insert(rateThresholds.end(), householdCount, rateThreshold);
+            minDurations.insert(minDurations.end(), householdCount, minDuration);
+            accumulatedTimes.insert(accumulatedTimes.end(), householdCount, 0);
+            activeFlags.insert(activeFlags.end(), householdCount, 0);
+            return ruleCount++;
+        }
+
+        /**
+         * @brief Override the parameters of a rule for a single household. Resets its state.
+         */
+        void setRule(const size_t rule, const size_t household, const float rateThreshold, const time_t minDuration) {
+            const size_t lane = rule * householdCount + household;
+            rateThresholds[lane] = rateThreshold;
+            minDurations[lane] = minDuration;
+            accumulatedTimes[lane] = 0;
+            activeFlags[lane] = 0;
+        }
+
+        /**
+         * @brief Update every household with its current flow rate.
+         *
+         * Equivalent to calling TimeBasedFlowRateCriterion::update for every lane.
+         *
+         * @param flowRates Flow rate of each household, in liters per minute (getHouseholdCount() entries).
+         * @param elapsedTime Time in seconds since the last update.
+         */
+        void update(const float* flowRates, const time_t elapsedTime) {
+            std::fill(actionMask.begin(), actionMask.end(), 0);
+
+            for (size_t rule = 0; rule < ruleCount; rule++) {
+                const size_t base = rule * householdCount;
+                kernel(flowRates, rateThresholds.data() + base, minDurations.data() + base,
+                    accumulatedTimes.data() + base, activeFlags.data() + base,
+                    householdCount, elapsedTime, ruleMask.data());
+
+                for (size_t word = 0; word < actionMask.size(); word++)
+                    actionMask[word] |= ruleMask[word];
+            }
+        }
+
+        /**
+         * @brief Bitmap of households whose valve should be closed, bit (i % 64) of word (i / 64).
+         */
+        [[nodiscard]] const std::vector<uint64_t>& getActionMask() const { return actionMask; }
+
+        [[nodiscard]] bool shouldCloseValve(const size_t household) const {
+            return (actionMask[household / 64] >> (household % 64)) & 1u;
+        }
+
+        [[nodiscard]] LeakPreventionAction getAction(const size_t household) const {
+            if (shouldCloseValve(household))
+                return LeakPreventionAction(ActionType::CLOSE_VALVE, ActionReason::EXCEEDED_FLOW_RATE);
+
+            return LeakPreventionAction(ActionType::NO_ACTION);
+        }
+
+        [[nodiscard]] time_t getAccumulatedTime(const size_t rule, const size_t household) const {
+            return accumulatedTimes[rule * householdCount + household];
+        }
+
+    private:
+        size_t householdCount;
+        size_t ruleCount = 0;
+        FlowRateKernel kernel;
+
+        std::vector<float> rateThresholds;
+        std::vector<time_t> minDurations;
+        std::vector<time_t> accumulatedTimes;
+        std::vector<uint8_t> activeFlags;
+
+        std::vector<uint64_t> ruleMask;
+        std::vector<uint64_t> actionMask;
+    };
+
+}
+#endif //FLOW_RATE_BATCH_HPP
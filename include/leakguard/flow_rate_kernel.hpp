@@ -0,0 +1,245 @@
+#ifndef FLOW_RATE_KERNEL_HPP
+#define FLOW_RATE_KERNEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define LEAK_LOGIC_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace lg {
+
+    /**
+     * @brief Implementations of the flow rate threshold-and-accumulate kernel.
+     */
+    enum class FlowRateKernelType {
+        SCALAR,
+        SSE42,
+        AVX2
+    };
+
+    /**
+     * @brief Applies TimeBasedFlowRateCriterion::update to an array of criteria (lanes).
+     *
+     * For every lane i:
+     *  - accumulatedTimes[i] is increased by elapsedTime if flowRates[i] >= rateThresholds[i], reset to 0 otherwise,
+     *  - activeFlags[i] is set to 1 if flowRates[i] >= rateThresholds[i], 0 otherwise,
+     *  - bit (i % 64) of tripMask[i / 64] is set if the lane is active and accumulatedTimes[i] >= minDurations[i].
+     *
+     * tripMask must hold (count + 63) / 64 words, which are overwritten. All kernels produce bit-identical results.
+     */
+    using FlowRateKernel = void (*)(
+        const float* flowRates, const float* rateThresholds, const time_t* minDurations,
+        time_t* accumulatedTimes, uint8_t* activeFlags, size_t count, time_t elapsedTime, uint64_t* tripMask);
+
+    namespace detail {
+
+        inline uint64_t flowRateLanesScalar(
+            const float* flowRates, const float* rateThresholds, const time_t* minDurations,
+            time_t* accumulatedTimes, uint8_t* activeFlags, const size_t count, const time_t elapsedTime) {
+            uint64_t bits = 0;
+            for (size_t i = 0; i < count; i++) {
+                const bool above = flowRates[i] >= rateThresholds[i];
+                const time_t next = above ? accumulatedTimes[i] + elapsedTime : 0;
+                accumulatedTimes[i] = next;
+                activeFlags[i] = above;
+                bits |= static_cast<uint64_t>(above & (next >= minDurations[i])) << i;
+            }
+            return bits;
+        }
+
+        inline void flowRateKernelScalar(
+            const float* flowRates, const float* rateThresholds, const time_t* minDurations,
+            time_t* accumulatedTimes, uint8_t* activeFlags, const size_t count, const time_t elapsedTime,
+            uint64_t* tripMask) {
+            for (size_t first = 0; first < count; first += 64) {
+                const size_t blockSize = count - first < 64 ? count - first : 64;
+                tripMask[first / 64] = flowRateLanesScalar(
+                    flowRates + first, rateThresholds + first, minDurations + first,
+                    accumulatedTimes + first, activeFlags + first, blockSize, elapsedTime);
+            }
+        }
+
+#ifdef LEAK_LOGIC_X86_SIMD
+        /**
+         * Handles 4 lanes: returns their trip bits and writes their active flags.
+         */
+        __attribute__((target("sse4.2")))
+        inline uint64_t flowRateLanesSse42(
+            const float* flowRates, const float* rateThresholds, const time_t* minDurations,
+            time_t* accumulatedTimes, uint8_t* activeFlags, const __m128i elapsed) {
+            const __m128 above = _mm_cmpge_ps(_mm_loadu_ps(flowRates), _mm_loadu_ps(rateThresholds));
+            const __m128i above32 = _mm_castps_si128(above);
+
+            const __m128i maskLo = _mm_cvtepi32_epi64(above32);
+            const __m128i maskHi = _mm_cvtepi32_epi64(_mm_srli_si128(above32, 8));
+
+            auto* accumulated = reinterpret_cast<__m128i*>(accumulatedTimes);
+            const __m128i accLo = _mm_and_si128(_mm_add_epi64(_mm_loadu_si128(accumulated), elapsed), maskLo);
+            const __m128i accHi = _mm_and_si128(_mm_add_epi64(_mm_loadu_si128(accumulated + 1), elapsed), maskHi);
+            _mm_storeu_si128(accumulated, accLo);
+            _mm_storeu_si128(accumulated + 1, accHi);
+
+            const auto* durations = reinterpret_cast<const __m128i*>(minDurations);
+            const __m128i tripLo = _mm_andnot_si128(_mm_cmpgt_epi64(_mm_loadu_si128(durations), accLo), maskLo);
+            const __m128i tripHi = _mm_andnot_si128(_mm_cmpgt_epi64(_mm_loadu_si128(durations + 1), accHi), maskHi);
+
+            const __m128i activeBytes = _mm_and_si128(
+                _mm_packs_epi16(_mm_packs_epi32(above32, above32), _mm_setzero_si128()), _mm_set1_epi8(1));
+            const int activeWord = _mm_cvtsi128_si32(activeBytes);
+            __builtin_memcpy(activeFlags, &activeWord, 4);
+
+            return static_cast<uint64_t>(
+                _mm_movemask_pd(_mm_castsi128_pd(tripLo)) | _mm_movemask_pd(_mm_castsi128_pd(tripHi)) << 2);
+        }
+
+        __attribute__((target("sse4.2")))
+        inline void flowRateKernelSse42(
+            const float* flowRates, const float* rateThresholds, const time_t* minDurations,
+            time_t* accumulatedTimes, uint8_t* activeFlags, const size_t count, const time_t elapsedTime,
+            uint64_t* tripMask) {
+            const __m128i elapsed = _mm_set1_epi64x(elapsedTime);
+
+            for (size_t first = 0; first < count; first += 64) {
+                const size_t blockSize = count - first < 64 ? count - first : 64;
+                uint64_t bits = 0;
+                size_t i = 0;
+
+                for (; i + 4 <= blockSize; i += 4) {
+                    const size_t lane = first + i;
+                    bits |= flowRateLanesSse42(
+                        flowRates + lane, rateThresholds + lane, minDurations + lane,
+                        accumulatedTimes + lane, activeFlags + lane, elapsed) << i;
+                }
+
+                if (i < blockSize) {
+                    const size_t lane = first + i;
+                    bits |= flowRateLanesScalar(
+                        flowRates + lane, rateThresholds + lane, minDurations + lane,
+                        accumulatedTimes + lane, activeFlags + lane, blockSize - i, elapsedTime) << i;
+                }
+
+                tripMask[first / 64] = bits;
+            }
+        }
+
+        /**
+         * Handles 8 lanes: returns their trip bits and writes their active flags.
+         */
+        __attribute__((target("avx2")))
+        inline uint64_t flowRateLanesAvx2(
+            const float* flowRates, const float* rateThresholds, const time_t* minDurations,
+            time_t* accumulatedTimes, uint8_t* activeFlags, const __m256i elapsed) {
+            const __m256 above = _mm256_cmp_ps(_mm256_loadu_ps(flowRates), _mm256_loadu_ps(rateThresholds), _CMP_GE_OQ);
+            const __m256i above32 = _mm256_castps_si256(above);
+            const __m128i above32Lo = _mm256_castsi256_si128(above32);
+            const __m128i above32Hi = _mm256_extracti128_si256(above32, 1);
+
+            const __m256i maskLo = _mm256_cvtepi32_epi64(above32Lo);
+            const __m256i maskHi = _mm256_cvtepi32_epi64(above32Hi);
+
+            auto* accumulated = reinterpret_cast<__m256i*>(accumulatedTimes);
+            const __m256i accLo = _mm256_and_si256(_mm256_add_epi64(_mm256_loadu_si256(accumulated), elapsed), maskLo);
+            const __m256i accHi = _mm256_and_si256(_mm256_add_epi64(_mm256_loadu_si256(accumulated + 1), elapsed), maskHi);
+            _mm256_storeu_si256(accumulated, accLo);
+            _mm256_storeu_si256(accumulated + 1, accHi);
+
+            const auto* durations = reinterpret_cast<const __m256i*>(minDurations);
+            const __m256i tripLo = _mm256_andnot_si256(_mm256_cmpgt_epi64(_mm256_loadu_si256(durations), accLo), maskLo);
+            const __m256i tripHi = _mm256_andnot_si256(_mm256_cmpgt_epi64(_mm256_loadu_si256(durations + 1), accHi), maskHi);
+
+            const __m128i activeBytes = _mm_and_si128(
+                _mm_packs_epi16(_mm_packs_epi32(above32Lo, above32Hi), _mm_setzero_si128()), _mm_set1_epi8(1));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(activeFlags), activeBytes);
+
+            return static_cast<uint64_t>(
+                _mm256_movemask_pd(_mm256_castsi256_pd(tripLo)) | _mm256_movemask_pd(_mm256_castsi256_pd(tripHi)) << 4);
+        }
+
+        __attribute__((target("avx2")))
+        inline void flowRateKernelAvx2(
+            const float* flowRates, const float* rateThresholds, const time_t* minDurations,
+            time_t* accumulatedTimes, uint8_t* activeFlags, const size_t count, const time_t elapsedTime,
+            uint64_t* tripMask) {
+            const __m256i elapsed = _mm256_set1_epi64x(elapsedTime);
+
+            for (size_t first = 0; first < count; first += 64) {
+                const size_t blockSize = count - first < 64 ? count - first : 64;
+                uint64_t bits = 0;
+                size_t i = 0;
+
+                for (; i + 8 <= blockSize; i += 8) {
+                    const size_t lane = first + i;
+                    bits |= flowRateLanesAvx2(
+                        flowRates + lane, rateThresholds + lane, minDurations + lane,
+                        accumulatedTimes + lane, activeFlags + lane, elapsed) << i;
+                }
+
+                if (i < blockSize) {
+                    const size_t lane = first + i;
+                    bits |= flowRateLanesScalar(
+                        flowRates + lane, rateThresholds + lane, minDurations + lane,
+                        accumulatedTimes + lane, activeFlags + lane, blockSize - i, elapsedTime) << i;
+                }
+
+                tripMask[first / 64] = bits;
+            }
+        }
+#endif
+
+    }
+
+    /**
+     * @brief Whether the given kernel can run on this CPU.
+     */
+    inline bool isFlowRateKernelSupported(const FlowRateKernelType type) {
+        switch (type) {
+            case FlowRateKernelType::SCALAR:
+                return true;
+#ifdef LEAK_LOGIC_X86_SIMD
+            case FlowRateKernelType::SSE42:
+                return sizeof(time_t) == 8 && __builtin_cpu_supports("sse4.2");
+            case FlowRateKernelType::AVX2:
+                return sizeof(time_t) == 8 && __builtin_cpu_supports("avx2");
+#endif
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * @brief Get a specific kernel implementation, falling back to the scalar one if it is not supported.
+     */
+    inline FlowRateKernel getFlowRateKernel(const FlowRateKernelType type) {
+        if (!isFlowRateKernelSupported(type))
+            return detail::flowRateKernelScalar;
+
+        switch (type) {
+#ifdef LEAK_LOGIC_X86_SIMD
+            case FlowRateKernelType::SSE42:
+                return detail::flowRateKernelSse42;
+            case FlowRateKernelType::AVX2:
+                return detail::flowRateKernelAvx2;
+#endif
+            default:
+                return detail::flowRateKernelScalar;
+        }
+    }
+
+    /**
+     * @brief Get the fastest kernel implementation supported by this CPU. Detection runs once.
+     */
+    inline FlowRateKernel getFlowRateKernel() {
+        static const FlowRateKernel kernel = [] {
+            if (isFlowRateKernelSupported(FlowRateKernelType::AVX2))
+                return getFlowRateKernel(FlowRateKernelType::AVX2);
+            return getFlowRateKernel(FlowRateKernelType::SSE42);
+        }();
+        return kernel;
+    }
+
+}
+#endif //FLOW_RATE_KERNEL_HPP
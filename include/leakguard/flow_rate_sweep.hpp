@@ -0,0 +1,152 @@
+#ifndef FLOW_RATE_SWEEP_HPP
+#define FLOW_RATE_SWEEP_HPP
+
+#include "leakguard/fleet_replay.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <ctime>
+#include <numeric>
+#include <span>
+#include <vector>
+
+namespace lg {
+
+    /**
+     * @brief Evaluates a grid of TimeBasedFlowRateCriterion parameters in a single pass over a flow series.
+     *
+     * Every (rateThreshold, minDuration) pair of the grid is a candidate. Thresholds are kept sorted, so
+     * one binary search per sample tells which of them the flow rate reaches, and all durations of a
+     * threshold share its accumulated time. Since a higher threshold never accumulates more time than a
+     * lower one, thresholds whose durations have all tripped form a prefix that is skipped entirely.
+     *
+     * Intended for host-side rule tuning.
+     */
+    class FlowRateSweep {
+    public:
+        static constexpr time_t NOT_TRIPPED = -1;
+
+        /**
+         * @param rateThresholds Candidate flow rate thresholds, in liters per minute.
+         * @param minDurations Candidate minimum durations, in seconds.
+         */
+        FlowRateSweep(const std::span<const float> rateThresholds, const std::span<const time_t> minDurations)
+            : thresholdOrder(sortedOrder(rateThresholds)),
+              durationOrder(sortedOrder(minDurations)),
+              durationCount(minDurations.size()) {
+            for (const size_t index : thresholdOrder)
+                sortedThresholds.push_back(rateThresholds[index]);
+            for (const size_t index : durationOrder)
+                sortedDurations.push_back(minDurations[index]);
+
+            reset();
+        }
+
+        /**
+         * @brief Clear all results to start a new series.
+         */
+        void reset() {
+            accumulatedTimes.assign(sortedThresholds.size(), 0);
+            nextDurations.assign(sortedThresholds.size(), 0);
+            firstTrips.assign(sortedThresholds.size() * durationCount, NOT_TRIPPED);
+            accumulatingCount = 0;
+            doneCount = durationCount == 0 ? sortedThresholds.size() : 0;
+            clock = 0;
+            lastTimestamp = 0;
+            started = false;
+        }
+
+        /**
+         * @brief Feed the next sample of a household's series, trip times are sample timestamps.
+         */
+        void feed(const ReplaySample& sample) {
+            const time_t elapsedTime = started ? sample.timestamp - lastTimestamp : 0;
+            lastTimestamp = sample.timestamp;
+            started = true;
+            feed(sample.flowRate, elapsedTime, sample.timestamp);
+        }
+
+        /**
+         * @brief Feed the next sample, trip times are the sum of elapsed times so far.
+         */
+        void feed(const float flowRate, const time_t elapsedTime) {
+            clock += elapsedTime;
+            feed(flowRate, elapsedTime, clock);
+        }
+
+        /**
+         * @brief Time at which a candidate tripped first, or NOT_TRIPPED.
+         *
+         * @param thresholdIndex Index into the rateThresholds passed to the constructor.
+         * @param durationIndex Index into the minDurations passed to the constructor.
+         */
+        [[nodiscard]] time_t getFirstTrip(const size_t thresholdIndex, const size_t durationIndex) const {
+            return firstTrips[thresholdIndex * durationCount + durationIndex];
+        }
+
+        /**
+         * @brief First trip times of all candidates, row-major by threshold index.
+         */
+        [[nodiscard]] std::span<const time_t> getFirstTrips() const { return firstTrips; }
+
+        [[nodiscard]] size_t getCandidateCount() const { return firstTrips.size(); }
+
+    private:
+        template <typename T>
+        static std::vector<size_t> sortedOrder(const std::span<const T> values) {
+            std::vector<size_t> order(values.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [&](const size_t a, const size_t b) {
+                return values[a] < values[b];
+            });
+            return order;
+        }
+
+        void feed(const float flowRate, const time_t elapsedTime, const time_t now) {
+            // Thresholds [0, reached) satisfy flowRate >= threshold. NaN never reaches any threshold.
+            const size_t reached = std::isnan(flowRate) ? 0 : static_cast<size_t>(
+                std::upper_bound(sortedThresholds.begin(), sortedThresholds.end(), flowRate,
+                    [](const float flow, const float threshold) { return flow < threshold; })
+                - sortedThresholds.begin());
+
+            for (size_t i = doneCount; i < reached; i++) {
+                const time_t accumulated = accumulatedTimes[i] + elapsedTime;
+                accumulatedTimes[i] = accumulated;
+
+                size_t next = nextDurations[i];
+                while (next < durationCount && accumulated >= sortedDurations[next]) {
+                    firstTrips[thresholdOrder[i] * durationCount + durationOrder[next]] = now;
+                    next++;
+                }
+                nextDurations[i] = next;
+
+                if (next == durationCount && i == doneCount)
+                    doneCount++;
+            }
+
+            for (size_t i = std::max(reached, doneCount); i < accumulatingCount; i++)
+                accumulatedTimes[i] = 0;
+            accumulatingCount = reached;
+        }
+
+        std::vector<size_t> thresholdOrder;
+        std::vector<size_t> durationOrder;
+        size_t durationCount;
+
+        std::vector<float> sortedThresholds;
+        std::vector<time_t> sortedDurations;
+
+        std::vector<time_t> accumulatedTimes;
+        std::vector<size_t> nextDurations;
+        std::vector<time_t> firstTrips;
+
+        size_t accumulatingCount = 0;
+        size_t doneCount = 0;
+        time_t clock = 0;
+        time_t lastTimestamp = 0;
+        bool started = false;
+    };
+
+}
+#endif //FLOW_RATE_SWEEP_HPP
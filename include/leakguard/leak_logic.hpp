@@ -3,20 +3,185 @@
 
 #include "leakguard/staticvector.hpp"
 #include "leakguard/staticstring.hpp"
+#include "leakguard/binary_config.hpp"
+#include "leakguard/config_parser.hpp"
 
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <limits>
 #include <memory>
+#include <new>
 #include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <cmath>
 #include <ctime>
 
 #define LEAK_LOGIC_MAX_CRITERIA 10
 #define LEAK_LOGIC_MAX_SERIALIZE_LENGTH 256
+#define LEAK_LOGIC_MAX_PROBES 256
+#define LEAK_LOGIC_CRITERION_SLOT_SIZE 128
+#define LEAK_LOGIC_VOLUME_MAX_BUCKETS 16
+
+// Define LEAK_LOGIC_FIXED_POINT to keep flow rates and volumes as integer centiliters, for targets without an FPU
 
 
 
 namespace lg {
 
+#ifdef LEAK_LOGIC_FIXED_POINT
+    /**
+     * @brief Flow rate, in centiliters per minute.
+     */
+    using FlowRate = int32_t;
+
+    /**
+     * @brief Volume, in centiliters.
+     */
+    using Volume = int32_t;
+#else
+    /**
+     * @brief Flow rate, in liters per minute.
+     */
+    using FlowRate = float;
+
+    /**
+     * @brief Volume, in liters.
+     */
+    using Volume = float;
+#endif
+
+    constexpr FlowRate flowRateFromCenti(const int32_t centilitersPerMinute) {
+#ifdef LEAK_LOGIC_FIXED_POINT
+        return centilitersPerMinute;
+#else
+        return static_cast<float>(centilitersPerMinute) / 100.0f;
+#endif
+    }
+
+    constexpr int32_t flowRateToCenti(const FlowRate flowRate) {
+#ifdef LEAK_LOGIC_FIXED_POINT
+        return flowRate;
+#else
+        return static_cast<int32_t>(flowRate * 100);
+#endif
+    }
+
+    /**
+     * @brief Convert a raw flow meter pulse count to a flow rate.
+     *
+     * @param pulses Pulses counted within the elapsed time.
+     * @param elapsedTime Time in seconds the pulses were counted over.
+     * @param pulsesPerLiter Flow meter calibration constant.
+     */
+    constexpr FlowRate flowRateFromPulses(const uint32_t pulses, const time_t elapsedTime, const uint32_t pulsesPerLiter) {
+        if (elapsedTime <= 0 || pulsesPerLiter == 0)
+            return 0;
+#ifdef LEAK_LOGIC_FIXED_POINT
+        return static_cast<int32_t>(static_cast<uint64_t>(pulses) * 6000 / (static_cast<uint64_t>(pulsesPerLiter) * elapsedTime));
+#else
+        return static_cast<float>(pulses) * 60.0f / (static_cast<float>(pulsesPerLiter) * static_cast<float>(elapsedTime));
+#endif
+    }
+
+    /**
+     * @brief Calibration of a pulse-counting flow meter, with what criteria need for pulse samples
+     * computed once, so that the samples need neither division nor floating point conversion.
+     */
+    struct PulseCalibration {
+#ifdef LEAK_LOGIC_FIXED_POINT
+        // Volume per pulse, as a 16.16 fixed-point number
+        using Factor = uint32_t;
+        static constexpr unsigned FRACTION_BITS = 16;
+#else
+        using Factor = float;
+#endif
+
+        PulseCalibration() = default;
+
+        /**
+         * @param pulsesPerLiter Flow meter pulses per liter, or 0 if there is no pulse input.
+         */
+        explicit PulseCalibration(const uint32_t pulsesPerLiter) : pulsesPerLiter(pulsesPerLiter) {
+            if (pulsesPerLiter == 0)
+                return;
+#ifdef LEAK_LOGIC_FIXED_POINT
+            volumePerPulse = (static_cast<uint32_t>(6000) << FRACTION_BITS) / pulsesPerLiter;
+#else
+            volumePerPulse = 60.0f / static_cast<float>(pulsesPerLiter);
+#endif
+        }
+
+        uint32_t pulsesPerLiter = 0;
+
+        /**
+         * @brief Volume of a single pulse, in flow rate units times seconds (volume * 60).
+         */
+        Factor volumePerPulse = 0;
+    };
+
+    /**
+     * @brief High 64 bits of the 128-bit product of a and b, without needing a 128-bit type.
+     */
+    constexpr uint64_t mulHigh(const uint64_t a, const uint64_t b) {
+        const uint64_t low = (a & 0xFFFFFFFFu) * (b & 0xFFFFFFFFu);
+        const uint64_t middle = (a >> 32) * (b & 0xFFFFFFFFu) + (low >> 32);
+        const uint64_t other = (a & 0xFFFFFFFFu) * (b >> 32) + (middle & 0xFFFFFFFFu);
+        return (a >> 32) * (b >> 32) + (middle >> 32) + (other >> 32);
+    }
+
+    /**
+     * @brief Reciprocal of a non-zero divisor for remainderBy(), computed once at configuration time.
+     */
+    constexpr uint64_t reciprocalOf(const uint64_t divisor) {
+        return std::numeric_limits<uint64_t>::max() / divisor;
+    }
+
+    /**
+     * @brief value % divisor without division, given reciprocalOf(divisor).
+     */
+    constexpr uint64_t remainderBy(const uint64_t value, const uint64_t divisor, const uint64_t reciprocal) {
+        uint64_t remainder = value - mulHigh(value, reciprocal) * divisor;
+
+        // The reciprocal is rounded down, so the quotient is at most 2 too small
+        while (remainder >= divisor)
+            remainder -= divisor;
+        return remainder;
+    }
+
+    /**
+     * @brief Convert a flow rate given in liters per minute. Meant for configuration and host tools,
+     * as it goes through floating point even in fixed-point mode.
+     */
+    constexpr FlowRate flowRateFromLitersPerMinute(const float litersPerMinute) {
+#ifdef LEAK_LOGIC_FIXED_POINT
+        return static_cast<int32_t>(litersPerMinute * 100.0f + (litersPerMinute < 0 ? -0.5f : 0.5f));
+#else
+        return litersPerMinute;
+#endif
+    }
+
+    constexpr Volume volumeFromCenti(const int32_t centiliters) {
+#ifdef LEAK_LOGIC_FIXED_POINT
+        return centiliters;
+#else
+        return static_cast<float>(centiliters) / 100.0f;
+#endif
+    }
+
+    constexpr int32_t volumeToCenti(const Volume volume) {
+#ifdef LEAK_LOGIC_FIXED_POINT
+        return volume;
+#else
+        return static_cast<int32_t>(volume * 100);
+#endif
+    }
+
     /**
      * @brief Leak prevention action type.
      */
@@ -31,22 +196,110 @@ namespace lg {
     enum class ActionReason {
         NONE,
         EXCEEDED_FLOW_RATE,
-        LEAK_DETECTED_BY_PROBE
+        LEAK_DETECTED_BY_PROBE,
+        EXCEEDED_VOLUME
+    };
+
+    /**
+     * @brief Bit-packed set of probe states, one bit per probe ID.
+     *
+     * A set bit means the probe detected a leak.
+     */
+    class ProbeMask {
+    public:
+        static constexpr size_t WORD_BITS = 64;
+        static constexpr size_t WORD_COUNT = LEAK_LOGIC_MAX_PROBES / WORD_BITS;
+
+        constexpr ProbeMask() = default;
+
+        /**
+         * @brief Packs an array of probe states into a mask.
+         */
+        explicit ProbeMask(const std::array<bool, LEAK_LOGIC_MAX_PROBES>& probeStates) {
+            for (size_t i = 0; i < probeStates.size(); i++) {
+                words[i / WORD_BITS] |= static_cast<uint64_t>(probeStates[i]) << (i % WORD_BITS);
+            }
+        }
+
+        /**
+         * @brief Create a mask from its raw words, bit (i % 64) of word (i / 64) being probe i.
+         */
+        static constexpr ProbeMask fromWords(const std::array<uint64_t, WORD_COUNT>& words) {
+            ProbeMask mask;
+            mask.words = words;
+            return mask;
+        }
+
+        [[nodiscard]] constexpr bool test(const size_t probeId) const {
+            return (words[probeId / WORD_BITS] >> (probeId % WORD_BITS)) & 1u;
+        }
+
+        [[nodiscard]] constexpr bool operator[](const size_t probeId) const { return test(probeId); }
+
+        constexpr void set(const size_t probeId, const bool wet = true) {
+            const uint64_t bit = uint64_t { 1 } << (probeId % WORD_BITS);
+            if (wet)
+                words[probeId / WORD_BITS] |= bit;
+            else
+                words[probeId / WORD_BITS] &= ~bit;
+        }
+
+        constexpr void reset(const size_t probeId) { set(probeId, false); }
+
+        constexpr void clear() { words = {}; }
+
+        [[nodiscard]] constexpr bool any() const {
+            uint64_t merged = 0;
+            for (const uint64_t word : words)
+                merged |= word;
+            return merged != 0;
+        }
+
+        /**
+         * @brief Find the lowest probe ID that detected a leak.
+         *
+         * @return The probe ID, or -1 if no probe detected a leak.
+         */
+        [[nodiscard]] constexpr int findFirst() const {
+            for (size_t i = 0; i < WORD_COUNT; i++) {
+                if (words[i] != 0)
+                    return static_cast<int>(i * WORD_BITS) + std::countr_zero(words[i]);
+            }
+            return -1;
+        }
+
+        [[nodiscard]] static constexpr size_t size() { return LEAK_LOGIC_MAX_PROBES; }
+
+        [[nodiscard]] constexpr const std::array<uint64_t, WORD_COUNT>& getWords() const { return words; }
+
+        constexpr bool operator==(const ProbeMask&) const = default;
+
+    private:
+        std::array<uint64_t, WORD_COUNT> words {};
     };
 
     /**
      * @brief State of sensors used for leak detection.
      */
     struct SensorState {
+        SensorState() = default;
+
+        SensorState(const FlowRate flowRate, const ProbeMask& probeStates)
+            : flowRate(flowRate), probeStates(probeStates) {}
+
+        SensorState(const FlowRate flowRate, const std::array<bool, LEAK_LOGIC_MAX_PROBES>& probeStates)
+            : flowRate(flowRate), probeStates(probeStates) {}
+
         /**
-         * @brief Water flow rate from the flow meter, specified in liters per minute.
+         * @brief Water flow rate from the flow meter, specified in liters per minute
+         * (centiliters per minute in fixed-point mode).
          */
-        float flowRate;
+        FlowRate flowRate = 0;
 
         /**
-         * @brief Array of probe states - true if the probe detected a leak, false otherwise.
+         * @brief Probe states - bit set if the probe detected a leak.
          */
-        std::array<bool, 256> probeStates;
+        ProbeMask probeStates;
     };
 
     /**
@@ -75,6 +328,8 @@ namespace lg {
          */
         [[nodiscard]] uint8_t getProbeId() const { return probeId; }
 
+        bool operator==(const LeakPreventionAction&) const = default;
+
     private:
         ActionType actionType;
         ActionReason reason;
@@ -88,12 +343,79 @@ namespace lg {
     public:
         virtual void update(const SensorState& sensorState, time_t elapsedTime) = 0;
 
+        /**
+         * @brief Advance the criterion by a span of constant sensor input, in time independent of its length.
+         *
+         * Must be equivalent to any sequence of update() calls with the same sensor state and elapsed times
+         * adding up to duration (exactly in fixed-point mode, up to rounding with floating point).
+         *
+         * @param sensorState The sensor state throughout the span.
+         * @param duration Length of the span, in seconds.
+         */
+        virtual void advance(const SensorState& sensorState, time_t duration) = 0;
+
+        /**
+         * @brief Update the criterion with a raw flow meter pulse count, keeping the last known probe states.
+         *
+         * @param calibration The flow meter calibration. pulsesPerLiter is 0 if there is no pulse input.
+         * @param pulses Pulses counted since the last update.
+         * @param elapsedTime Time in seconds since the last update.
+         * @return Whether the criterion handled the pulses. If not, the caller converts them to a flow rate
+         *         and calls update() instead.
+         */
+        virtual bool updatePulses(const PulseCalibration& /*calibration*/, uint32_t /*pulses*/, time_t /*elapsedTime*/) {
+            return false;
+        }
+
+        /**
+         * @brief Apply a single probe change, for criteria that depend on probe states.
+         *
+         * @param probeStates Probe states, already including the change.
+         * @param probeId The probe that changed state.
+         * @param wet Whether the probe now detects a leak.
+         */
+        virtual void onProbeChanged(const ProbeMask& /*probeStates*/, uint8_t /*probeId*/, bool /*wet*/) {}
+
         [[nodiscard]] virtual std::optional<LeakPreventionAction> getAction() const = 0;
 
+        /**
+         * @brief Returned by timeUntilAction() if the criterion cannot take action without a sensor change.
+         */
+        static constexpr time_t NEVER = std::numeric_limits<time_t>::max();
+
+        /**
+         * @brief Time in seconds until the criterion could take action, assuming the last sensor sample persists.
+         *
+         * @return 0 if the criterion already takes action, NEVER if it cannot without a sensor change.
+         */
+        [[nodiscard]] virtual time_t timeUntilAction() const = 0;
+
+        /**
+         * @brief The criterion's main accumulator, for status reporting. Meaning depends on the criterion.
+         */
+        [[nodiscard]] virtual int32_t getAccumulated() const { return 0; }
+
         virtual ~LeakDetectionCriterion() = default;
 
         [[nodiscard]] virtual StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH> serialize() const = 0;
         static std::unique_ptr<LeakDetectionCriterion> deserialize(const StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH>& serialized);
+
+        /**
+         * @brief Write the criterion as a single record of the binary configuration format.
+         */
+        virtual void serializeBinary(BinaryWriter& writer) const = 0;
+
+        /**
+         * @brief Write the runtime state of the criterion (not its configuration).
+         */
+        virtual void saveState(BinaryWriter& writer) const = 0;
+
+        /**
+         * @brief Restore runtime state written by saveState().
+         *
+         * @return Whether the state was valid for this criterion.
+         */
+        virtual bool restoreState(BinaryReader& reader) = 0;
     };
 
     /**
@@ -104,29 +426,84 @@ namespace lg {
     class TimeBasedFlowRateCriterion final : public LeakDetectionCriterion {
     public:
         /**
-        * @param rateThreshold Flow rate threshold, in liters per minute.
+         * @brief Parameters of the criterion. Not changed by updates, so one can be shared by many
+         * instances of the state (see SharedCriteria).
+         */
+        struct Config {
+            using Criterion = TimeBasedFlowRateCriterion;
+
+            FlowRate rateThreshold;
+
+            /**
+             * rateThreshold in centiliters per minute, at least 0, for the pulse path.
+             */
+            uint32_t centiThreshold;
+            time_t minDuration;
+        };
+
+        /**
+         * @brief Runtime state of the criterion.
+         */
+        struct State {
+            time_t accumulatedTime = 0;
+            bool active = false;
+        };
+
+        /**
+        * @param rateThreshold Flow rate threshold, in liters per minute (centiliters per minute in fixed-point mode).
         * @param minDuration Minimum duration for exceeded flow rate, in seconds.
         */
-        TimeBasedFlowRateCriterion(const float rateThreshold, const time_t minDuration)
-            : rateThreshold(rateThreshold), minDuration(minDuration),
-              accumulatedTime(0), active(false) {}
+        TimeBasedFlowRateCriterion(const FlowRate rateThreshold, const time_t minDuration)
+            : config(makeConfig(rateThreshold, minDuration)) {}
+
+        static Config makeConfig(const FlowRate rateThreshold, const time_t minDuration) {
+            const int32_t centi = flowRateToCenti(rateThreshold);
+            return Config { rateThreshold, static_cast<uint32_t>(centi > 0 ? centi : 0), minDuration };
+        }
 
-        [[nodiscard]] float getRateThreshold() const { return rateThreshold; }
-        [[nodiscard]] time_t getMinDuration() const { return minDuration; }
+        [[nodiscard]] FlowRate getRateThreshold() const { return config.rateThreshold; }
+        [[nodiscard]] time_t getMinDuration() const { return config.minDuration; }
+        [[nodiscard]] const Config& getConfig() const { return config; }
+        [[nodiscard]] const State& getState() const { return state; }
 
         void update(const SensorState& sensorState, const time_t elapsedTime) override {
-            if (sensorState.flowRate >= rateThreshold) {
-                accumulatedTime += elapsedTime;
-                active = true;
-            }
-            else {
-                accumulatedTime = 0;
-                active = false;
-            }
+            advance(sensorState, elapsedTime);
+        }
+
+        void advance(const SensorState& sensorState, const time_t duration) override {
+            advance(config, state, sensorState, duration);
+        }
+
+        static void advance(const Config& config, State& state, const SensorState& sensorState, const time_t duration) {
+            // Steps of constant input only add up or keep resetting, so one step is enough
+            step(state, sensorState.flowRate >= config.rateThreshold, duration);
+        }
+
+        bool updatePulses(const PulseCalibration& calibration, const uint32_t pulses, const time_t elapsedTime) override {
+            return updatePulses(config, state, calibration, pulses, elapsedTime);
+        }
+
+        static bool updatePulses(const Config& config, State& state, const PulseCalibration& calibration,
+                                 const uint32_t pulses, const time_t elapsedTime) {
+            if (calibration.pulsesPerLiter == 0)
+                return false;
+
+            // pulses / pulsesPerLiter / (elapsedTime / 60) >= centi / 100, with both sides multiplied out.
+            // Without elapsed time the rate is 0, as in flowRateFromPulses().
+            const uint64_t pulseThreshold = static_cast<uint64_t>(config.centiThreshold) * calibration.pulsesPerLiter;
+            const bool exceeded = elapsedTime > 0
+                ? static_cast<uint64_t>(pulses) * 6000 >= pulseThreshold * static_cast<uint64_t>(elapsedTime)
+                : pulseThreshold == 0;
+            step(state, exceeded, elapsedTime);
+            return true;
         }
 
         [[nodiscard]] std::optional<LeakPreventionAction> getAction() const override {
-            if (active && accumulatedTime >= minDuration) {
+            return getAction(config, state);
+        }
+
+        static std::optional<LeakPreventionAction> getAction(const Config& config, const State& state) {
+            if (state.active && state.accumulatedTime >= config.minDuration) {
                 return LeakPreventionAction(
                     ActionType::CLOSE_VALVE,
                     ActionReason::EXCEEDED_FLOW_RATE
@@ -135,216 +512,1819 @@ namespace lg {
             return std::nullopt;
         }
 
+        /**
+         * @brief Seconds the flow rate has been at or above the threshold.
+         */
+        [[nodiscard]] int32_t getAccumulated() const override {
+            return static_cast<int32_t>(state.accumulatedTime);
+        }
+
+        [[nodiscard]] time_t timeUntilAction() const override {
+            return timeUntilAction(config, state);
+        }
+
+        static time_t timeUntilAction(const Config& config, const State& state) {
+            if (!state.active)
+                return NEVER;
+
+            return state.accumulatedTime >= config.minDuration ? 0 : config.minDuration - state.accumulatedTime;
+        }
+
         [[nodiscard]] StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH> serialize() const override {
             StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH> serialized;
             serialized += StaticString<8>("T,");
-            serialized += StaticString<8>::Of(static_cast<int>(rateThreshold * 100));
+            serialized += StaticString<8>::Of(flowRateToCenti(config.rateThreshold));
             serialized += StaticString<1>(",");
-            serialized += StaticString<8>::Of(static_cast<int>(minDuration));
+            serialized += StaticString<8>::Of(static_cast<int>(config.minDuration));
             serialized += StaticString<1>(",");
 
             return serialized;
         }
 
         static std::unique_ptr<TimeBasedFlowRateCriterion> deserialize(const StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH>& serialized) {
-            StaticString<16> buffer;
-
-            enum BufferState { TYPE, RATE_THRESH, MIN_DURATION };
-            BufferState state = TYPE;
-
-            float rateThreshold = 0.0f;
+            ParsedCriterion parsed;
+            FlowRate rateThreshold = 0;
             time_t minDuration = 0;
 
-            for (int i = 0; i < serialized.GetLength(); i++) {
-                const char c = serialized[i];
-                buffer += c;
+            if (!ConfigParser::parseRecord(std::string_view(serialized.ToCStr(), serialized.GetLength()), parsed)
+                || !fromParsed(parsed, rateThreshold, minDuration))
+                return nullptr;
 
-                if (c == ',') {
-                    buffer.Truncate(buffer.GetLength() - 1);
-                    switch (state) {
-                        case TYPE:
-                            state = RATE_THRESH;
-                        break;
-                        case RATE_THRESH:
-                            rateThreshold = static_cast<float>(buffer.ToInteger<int>()) / 100.0f;
-                            state = MIN_DURATION;
-                        break;
-                        case MIN_DURATION:
-                            minDuration = buffer.ToInteger<int>();
-                            auto criterion = std::make_unique<TimeBasedFlowRateCriterion>(rateThreshold, minDuration);
-                            return criterion;
-                    }
-                    buffer.Clear();
-                }
-            }
+            return std::make_unique<TimeBasedFlowRateCriterion>(rateThreshold, minDuration);
+        }
+
+        /**
+         * @brief Extract the criterion parameters from a parsed text record without constructing it.
+         *
+         * @return Whether the record describes this criterion.
+         */
+        static bool fromParsed(const ParsedCriterion& parsed, FlowRate& rateThreshold, time_t& minDuration) {
+            if (parsed.type != 'T' || parsed.fieldCount != 2)
+                return false;
 
-            return nullptr;
+            rateThreshold = flowRateFromCenti(parsed.fields[0]);
+            minDuration = parsed.fields[1];
+            return true;
         }
 
-    private:
-        float rateThreshold;
-        time_t minDuration;
-        time_t accumulatedTime;
+        void serializeBinary(BinaryWriter& writer) const override {
+            writer.beginRecord('T');
+            writer.writeI32(flowRateToCenti(config.rateThreshold));
+            writer.writeU32(static_cast<uint32_t>(config.minDuration));
+            writer.endRecord();
+        }
 
-        bool active;
-    };
+        /**
+         * @brief Parse the criterion parameters from a binary configuration record.
+         *
+         * @return Whether the parameters were parsed successfully.
+         */
+        static bool parseBinary(const BinaryConfigView::Record& record, FlowRate& rateThreshold, time_t& minDuration) {
+            if (record.type != 'T' || record.length != 8)
+                return false;
 
-    /**
-     * @brief Detection of leaks based on flood signals from a specific probe.
-     *
-     * If the specified probe has emitted a signal, the CLOSE_VALVE action is taken.
-     */
-    class ProbeLeakDetectionCriterion final : public LeakDetectionCriterion {
-    public:
-        void update(const SensorState& sensorState, const time_t elapsedTime) override {
-            leakDetected = false;
-            for (size_t i = 0; i < sensorState.probeStates.size(); i++) {
-                if (sensorState.probeStates[i]) {
-                    probeId = i;
-                    leakDetected = true;
-                    break;
-                }
-            }
+            BinaryReader reader(record.payload, record.length);
+            rateThreshold = flowRateFromCenti(reader.readI32());
+            minDuration = reader.readU32();
+            return reader.isValid();
         }
 
-        [[nodiscard]] std::optional<LeakPreventionAction> getAction() const override {
-            if (leakDetected) {
-                return LeakPreventionAction(
-                    ActionType::CLOSE_VALVE,
-                    ActionReason::LEAK_DETECTED_BY_PROBE,
-                    probeId
-                );
-            }
-            return std::nullopt;
+        void saveState(BinaryWriter& writer) const override {
+            writer.writeU32(static_cast<uint32_t>(state.accumulatedTime));
+            writer.writeU8(state.active);
         }
 
-        [[nodiscard]] StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH> serialize() const override {
-            StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH> serialized;
-            serialized += StaticString<8>("P,");
+        bool restoreState(BinaryReader& reader) override {
+            const time_t restoredTime = reader.readU32();
+            const bool restoredActive = reader.readU8() != 0;
+            if (!reader.isValid())
+                return false;
 
-            return serialized;
+            state.accumulatedTime = restoredTime;
+            state.active = restoredActive;
+            return true;
         }
 
-        static std::unique_ptr<ProbeLeakDetectionCriterion> deserialize(const StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH>& serialized) {
-            return std::make_unique<ProbeLeakDetectionCriterion>(); // Ehh, whatever
+    private:
+        static void step(State& state, const bool exceeded, const time_t elapsedTime) {
+            if (exceeded) {
+                state.accumulatedTime += elapsedTime;
+                state.active = true;
+            }
+            else {
+                state.accumulatedTime = 0;
+                state.active = false;
+            }
         }
 
-    private:
-        uint8_t probeId {};
-        bool leakDetected = false;
+        Config config;
+        State state;
     };
 
     /**
-     * @brief Leak detection logic.
+     * @brief Detection of leaks based on the volume of water used within a sliding time window.
+     *
+     * If more than a specified volume flowed within the last window seconds, the CLOSE_VALVE action is
+     * taken. Unlike TimeBasedFlowRateCriterion, short pauses in the flow do not reset it, so it catches
+     * e.g. a running toilet that keeps refilling.
+     *
+     * The window is a ring buffer of time buckets with a running sum, so update() takes constant time
+     * regardless of the window length. Volume within the oldest bucket leaves the window all at once.
      */
-    class LeakLogic {
+    class VolumeWindowCriterion final : public LeakDetectionCriterion {
+#ifdef LEAK_LOGIC_FIXED_POINT
+        // A single bucket fits in 32 bits; the sum over a long window may not
+        using Bucket = int32_t;
+        using Sum = int64_t;
+
+        static constexpr unsigned PULSE_FRACTION_BITS = PulseCalibration::FRACTION_BITS;
+
+        // Reciprocal of a duration, as a 16.16 fixed-point number
+        using Reciprocal = uint32_t;
+        static constexpr Reciprocal RECIPROCAL_ONE = 1u << PULSE_FRACTION_BITS;
+#else
+        using Bucket = float;
+        using Sum = float;
+        using Reciprocal = float;
+        static constexpr Reciprocal RECIPROCAL_ONE = 1.0f;
+#endif
+
     public:
         /**
-         * @brief Get the global logic singleton.
+         * @brief Parameters of the criterion. Not changed by updates, so one can be shared by many
+         * instances of the state (see SharedCriteria).
          */
-        static LeakLogic& getInstance() {
-            static LeakLogic instance;
-            return instance;
-        }
+        struct Config {
+            using Criterion = VolumeWindowCriterion;
 
-        /**
-         * @brief Update the leak logic with the current sensor state and time elapsed since the last update.
-         *
-         * @param sensorState The current sensor state.
-         * @param elapsedTime Time in seconds since the last update.
-         */
-        void update(const SensorState& sensorState, const time_t elapsedTime) {
-            for (const auto& criterion : criteria) {
-                criterion->update(sensorState, elapsedTime);
-            }
+            Volume maxVolume;
+            uint32_t window;
+            uint32_t bucketWidth;
+            uint8_t bucketCount;
 
-            probeLeakCriterion.update(sensorState, elapsedTime);
-        }
+            /**
+             * reciprocalOf(bucketCount * bucketWidth), so skipping whole revolutions of the ring needs no division.
+             */
+            uint64_t ringReciprocal;
+        };
 
         /**
-         * @brief Get the action determined by specified leak detection criteria.
+         * @brief Runtime state of the criterion.
          */
-        [[nodiscard]] LeakPreventionAction getAction() const {
-            for (auto& criterion : criteria) {
-                if (const auto action = criterion->getAction()) {
-                    return *action;
-                }
-            }
+        struct State {
+            Sum sum = 0;
 
-            if (const auto probeAction = probeLeakCriterion.getAction())
-                return probeAction.value();
+            /**
+             * Volumes are kept in flow rate units times seconds (volume * 60), so no division is needed per update.
+             */
+            Bucket buckets[LEAK_LOGIC_VOLUME_MAX_BUCKETS] {};
+            uint32_t offset = 0;
+#ifdef LEAK_LOGIC_FIXED_POINT
+            uint32_t pulseFraction = 0;
+#endif
 
-            return LeakPreventionAction(ActionType::NO_ACTION);
-        }
+            /**
+             * Volume of the last sample and its duration, to project it forward in timeUntilAction().
+             */
+            Bucket lastVolume = 0;
+            uint32_t lastElapsed = 1;
+
+            /**
+             * 1 / lastElapsed, recomputed only when the sample period changes, so spreading pulse samples
+             * over buckets needs no division.
+             */
+            Reciprocal lastReciprocal = RECIPROCAL_ONE;
+
+            // Last, so it packs with the end of the struct
+            uint8_t head = 0;
+        };
 
         /**
-         * @brief Add a criterion for leak detection.
-         *
-         * @param criterion A unique_ptr to a leak detection criterion object.
-         * @return Whether the criterion was added successfully.
-         */
-        bool addCriterion(std::unique_ptr<LeakDetectionCriterion> criterion) {
-            return criteria.Append(std::move(criterion));
+        * @param maxVolume Maximum volume within the window, in liters (centiliters in fixed-point mode).
+        * @param window Window length, in seconds.
+        * @param bucketWidth Bucket granularity, in seconds. Widened if the window would need more than
+        *                    LEAK_LOGIC_VOLUME_MAX_BUCKETS buckets.
+        */
+        VolumeWindowCriterion(const Volume maxVolume, const time_t window, const time_t bucketWidth)
+            : config(makeConfig(maxVolume, window, bucketWidth)) {}
+
+        static Config makeConfig(const Volume maxVolume, const time_t window, const time_t bucketWidth) {
+            const uint32_t clampedWindow = static_cast<uint32_t>(window > 0 ? window : 1);
+            const uint32_t width = chooseBucketWidth(clampedWindow, bucketWidth);
+            const uint8_t count = static_cast<uint8_t>((clampedWindow + width - 1) / width);
+            return Config { maxVolume, clampedWindow, width, count, reciprocalOf(static_cast<uint64_t>(count) * width) };
         }
 
+        [[nodiscard]] Volume getMaxVolume() const { return config.maxVolume; }
+        [[nodiscard]] time_t getWindow() const { return config.window; }
+        [[nodiscard]] time_t getBucketWidth() const { return config.bucketWidth; }
+        [[nodiscard]] size_t getBucketCount() const { return config.bucketCount; }
+        [[nodiscard]] const Config& getConfig() const { return config; }
+        [[nodiscard]] const State& getState() const { return state; }
+
         /**
-         * @brief Gets an iterator for the leak detection criteria list.
+         * @brief Volume within the window, in liters (centiliters in fixed-point mode).
          */
-        StaticVector<std::unique_ptr<LeakDetectionCriterion>, LEAK_LOGIC_MAX_CRITERIA>::Iterator getCriteria() {
-            return criteria.begin();
+        [[nodiscard]] Volume getVolume() const { return getVolume(state); }
+
+        static Volume getVolume(const State& state) { return static_cast<Volume>(state.sum / 60); }
+
+        void update(const SensorState& sensorState, const time_t elapsedTime) override {
+            advance(sensorState, elapsedTime);
         }
 
-        /**
-         * @brief Removes a criterion for leak detection from the list.
-         *
-         * @param index Index of the criterion to remove.
-         * @return Whether the criterion was removed successfully.
-         */
-        bool removeCriterion(const uint8_t index) {
-            return criteria.RemoveIndex(index);
+        void advance(const SensorState& sensorState, const time_t duration) override {
+            advance(config, state, sensorState, duration);
         }
 
-        void clearCriteria() {
-            criteria.Clear();
+        static void advance(const Config& config, State& state, const SensorState& sensorState, const time_t duration) {
+            // accumulate() skips whole revolutions of the ring, so this takes at most 2 * bucketCount + 1 steps
+            accumulate(config, state, sensorState.flowRate, duration);
+            state.lastVolume = sensorState.flowRate;
+            state.lastElapsed = 1;
+            state.lastReciprocal = RECIPROCAL_ONE;
         }
 
-        [[nodiscard]] StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH> serialize() const {
-            StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH> serialized;
+        bool updatePulses(const PulseCalibration& calibration, const uint32_t pulses, const time_t elapsedTime) override {
+            return updatePulses(config, state, calibration, pulses, elapsedTime);
+        }
 
-            for (int i = 0; i < criteria.GetSize(); i++) {
-                serialized += criteria[i]->serialize();
-                serialized += StaticString<1>("|");
+        static bool updatePulses(const Config& config, State& state, const PulseCalibration& calibration,
+                                 const uint32_t pulses, const time_t elapsedTime) {
+            if (calibration.pulsesPerLiter == 0)
+                return false;
+
+#ifdef LEAK_LOGIC_FIXED_POINT
+            // Keep the fractional part, so volume is not lost with each sample
+            const uint64_t scaled = static_cast<uint64_t>(pulses) * calibration.volumePerPulse + state.pulseFraction;
+            const Bucket volume = static_cast<Bucket>(scaled >> PULSE_FRACTION_BITS);
+            state.pulseFraction = static_cast<uint32_t>(scaled & ((1u << PULSE_FRACTION_BITS) - 1));
+#else
+            const Bucket volume = static_cast<Bucket>(pulses) * calibration.volumePerPulse;
+#endif
+
+            const uint32_t elapsed = elapsedTime > 0 ? static_cast<uint32_t>(elapsedTime) : 0;
+            if (elapsed > 0) {
+                state.lastVolume = volume;
+
+                // The only division left on the pulse path, and only when the sample period changes
+                if (elapsed != state.lastElapsed) {
+                    state.lastElapsed = elapsed;
+#ifdef LEAK_LOGIC_FIXED_POINT
+                    state.lastReciprocal = RECIPROCAL_ONE / elapsed;
+#else
+                    state.lastReciprocal = RECIPROCAL_ONE / static_cast<Reciprocal>(elapsed);
+#endif
+                }
+            }
+
+            if (elapsed <= config.bucketWidth - state.offset) {
+                state.buckets[state.head] += volume;
+                state.sum += volume;
+                state.offset += elapsed;
+                if (state.offset == config.bucketWidth)
+                    advanceBucket(config, state);
+                return true;
+            }
+
+            // Sample spans buckets - spread it evenly, which needs the rate after all
+#ifdef LEAK_LOGIC_FIXED_POINT
+            // Rounds down, so the remainder below is never negative
+            const Bucket rate = static_cast<Bucket>(
+                (static_cast<int64_t>(volume) * state.lastReciprocal) >> PULSE_FRACTION_BITS);
+#else
+            const Bucket rate = volume * state.lastReciprocal;
+#endif
+
+            accumulate(config, state, rate, elapsedTime);
+            const Bucket remainder = volume - rate * static_cast<Bucket>(elapsed);
+            state.buckets[state.head] += remainder;
+            state.sum += remainder;
+            return true;
+        }
+
+        [[nodiscard]] std::optional<LeakPreventionAction> getAction() const override {
+            return getAction(config, state);
+        }
+
+        static std::optional<LeakPreventionAction> getAction(const Config& config, const State& state) {
+            if (state.sum >= static_cast<Sum>(config.maxVolume) * 60) {
+                return LeakPreventionAction(
+                    ActionType::CLOSE_VALVE,
+                    ActionReason::EXCEEDED_VOLUME
+                );
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * @brief Volume within the window, in centiliters.
+         */
+        [[nodiscard]] int32_t getAccumulated() const override {
+            return volumeToCenti(getVolume());
+        }
+
+        [[nodiscard]] time_t timeUntilAction() const override {
+            return timeUntilAction(config, state);
+        }
+
+        static time_t timeUntilAction(const Config& config, const State& state) {
+            const Sum limit = static_cast<Sum>(config.maxVolume) * 60;
+            if (state.sum >= limit)
+                return 0;
+            if (state.lastVolume <= 0)
+                return NEVER;
+
+            // Play the ring forward at the last rate. After one revolution every bucket holds the same
+            // volume, so if the limit is not reached by then, it never is.
+            Bucket projected[LEAK_LOGIC_VOLUME_MAX_BUCKETS];
+            for (size_t i = 0; i < config.bucketCount; i++)
+                projected[i] = state.buckets[i];
+
+            Sum projectedSum = state.sum;
+            uint8_t projectedHead = state.head;
+            uint32_t projectedOffset = state.offset;
+            time_t elapsed = 0;
+            for (size_t i = 0; i <= config.bucketCount; i++) {
+                const uint32_t step = config.bucketWidth - projectedOffset;
+                const Sum gain = static_cast<Sum>(state.lastVolume) * step / state.lastElapsed;
+                if (projectedSum + gain >= limit) {
+                    const Sum missing = (limit - projectedSum) * state.lastElapsed;
+                    if constexpr (std::is_floating_point_v<Sum>)
+                        return elapsed + static_cast<time_t>(std::ceil(missing / state.lastVolume));
+                    else
+                        return elapsed + static_cast<time_t>((missing + state.lastVolume - 1) / state.lastVolume);
+                }
+
+                projected[projectedHead] += static_cast<Bucket>(gain);
+                projectedSum += gain;
+                elapsed += step;
+                projectedOffset = 0;
+                projectedHead = static_cast<uint8_t>(projectedHead + 1 == config.bucketCount ? 0 : projectedHead + 1);
+                projectedSum -= projected[projectedHead];
+                projected[projectedHead] = 0;
             }
+            return NEVER;
+        }
+
+        [[nodiscard]] StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH> serialize() const override {
+            StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH> serialized;
+            serialized += StaticString<8>("V,");
+            serialized += StaticString<8>::Of(volumeToCenti(config.maxVolume));
+            serialized += StaticString<1>(",");
+            serialized += StaticString<8>::Of(static_cast<int>(config.window));
+            serialized += StaticString<1>(",");
+            serialized += StaticString<8>::Of(static_cast<int>(config.bucketWidth));
+            serialized += StaticString<1>(",");
 
             return serialized;
         }
 
-        void loadFromString(const StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH>& serialized) {
-            clearCriteria();
+        static std::unique_ptr<VolumeWindowCriterion> deserialize(const StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH>& serialized) {
+            ParsedCriterion parsed;
+            Volume maxVolume = 0;
+            time_t window = 0;
+            time_t bucketWidth = 0;
 
-            StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH> buffer;
-            for (int i = 0; i < serialized.GetLength(); i++) {
-                const char c = serialized[i];
-                buffer += c;
+            if (!ConfigParser::parseRecord(std::string_view(serialized.ToCStr(), serialized.GetLength()), parsed)
+                || !fromParsed(parsed, maxVolume, window, bucketWidth))
+                return nullptr;
 
-                if (c == '|') {
-                    buffer.Truncate(buffer.GetLength() - 1);
-                    switch (buffer[0]) {
-                        case 'T':
-                            addCriterion(TimeBasedFlowRateCriterion::deserialize(buffer));
-                        break;
-                        default:
-                            break;
-                    }
-                    buffer.Clear();
+            return std::make_unique<VolumeWindowCriterion>(maxVolume, window, bucketWidth);
+        }
+
+        /**
+         * @brief Extract the criterion parameters from a parsed text record without constructing it.
+         *
+         * @return Whether the record describes this criterion.
+         */
+        static bool fromParsed(const ParsedCriterion& parsed, Volume& maxVolume, time_t& window, time_t& bucketWidth) {
+            if (parsed.type != 'V' || parsed.fieldCount != 3)
+                return false;
+
+            maxVolume = volumeFromCenti(parsed.fields[0]);
+            window = parsed.fields[1];
+            bucketWidth = parsed.fields[2];
+            return true;
+        }
+
+        void serializeBinary(BinaryWriter& writer) const override {
+            writer.beginRecord('V');
+            writer.writeI32(volumeToCenti(config.maxVolume));
+            writer.writeU32(config.window);
+            writer.writeU32(config.bucketWidth);
+            writer.endRecord();
+        }
+
+        /**
+         * @brief Parse the criterion parameters from a binary configuration record.
+         *
+         * @return Whether the parameters were parsed successfully.
+         */
+        static bool parseBinary(const BinaryConfigView::Record& record, Volume& maxVolume, time_t& window, time_t& bucketWidth) {
+            if (record.type != 'V' || record.length != 12)
+                return false;
+
+            BinaryReader reader(record.payload, record.length);
+            maxVolume = volumeFromCenti(reader.readI32());
+            window = reader.readU32();
+            bucketWidth = reader.readU32();
+            return reader.isValid();
+        }
+
+        void saveState(BinaryWriter& writer) const override {
+            writer.writeU8(state.head);
+            writer.writeU32(state.offset);
+            for (size_t i = 0; i < config.bucketCount; i++) {
+                if constexpr (std::is_floating_point_v<Bucket>)
+                    writer.writeF32(state.buckets[i]);
+                else
+                    writer.writeI32(state.buckets[i]);
+            }
+        }
+
+        bool restoreState(BinaryReader& reader) override {
+            const uint8_t restoredHead = reader.readU8();
+            const uint32_t restoredOffset = reader.readU32();
+            Bucket restoredBuckets[LEAK_LOGIC_VOLUME_MAX_BUCKETS] {};
+            for (size_t i = 0; i < config.bucketCount; i++) {
+                if constexpr (std::is_floating_point_v<Bucket>)
+                    restoredBuckets[i] = reader.readF32();
+                else
+                    restoredBuckets[i] = reader.readI32();
+            }
+
+            if (!reader.isValid() || restoredHead >= config.bucketCount || restoredOffset >= config.bucketWidth)
+                return false;
+
+            state.head = restoredHead;
+            state.offset = restoredOffset;
+            for (size_t i = 0; i < config.bucketCount; i++)
+                state.buckets[i] = restoredBuckets[i];
+            recomputeSum(config, state);
+            return true;
+        }
+
+    private:
+        static void accumulate(const Config& config, State& state, const FlowRate flowRate, const time_t elapsedTime) {
+            uint64_t remaining = elapsedTime > 0 ? static_cast<uint64_t>(elapsedTime) : 0;
+
+            // Anything older than the whole ring is overwritten anyway, so skip whole revolutions of it,
+            // which leave the head where it is
+            const uint64_t ringTime = static_cast<uint64_t>(config.bucketCount) * config.bucketWidth;
+            if (remaining > ringTime)
+                remaining = ringTime + remainderBy(remaining - ringTime, ringTime, config.ringReciprocal);
+
+            while (remaining > 0) {
+                const uint32_t step = static_cast<uint32_t>(
+                    remaining < config.bucketWidth - state.offset ? remaining : config.bucketWidth - state.offset);
+                const Bucket volume = flowRate * static_cast<Bucket>(step);
+                state.buckets[state.head] += volume;
+                state.sum += volume;
+                state.offset += step;
+                remaining -= step;
+
+                if (state.offset == config.bucketWidth)
+                    advanceBucket(config, state);
+            }
+        }
+
+        static uint32_t chooseBucketWidth(const uint32_t window, const time_t requestedWidth) {
+            const uint32_t minWidth = (window + LEAK_LOGIC_VOLUME_MAX_BUCKETS - 1) / LEAK_LOGIC_VOLUME_MAX_BUCKETS;
+            const uint32_t width = requestedWidth > 0 ? static_cast<uint32_t>(requestedWidth) : 1;
+            if (width > window)
+                return window;
+            return width < minWidth ? minWidth : width;
+        }
+
+        static void advanceBucket(const Config& config, State& state) {
+            state.offset = 0;
+            state.head = static_cast<uint8_t>(state.head + 1 == config.bucketCount ? 0 : state.head + 1);
+            state.sum -= state.buckets[state.head];
+            state.buckets[state.head] = 0;
+
+            // Recompute once per revolution, so rounding errors of the running sum cannot build up
+            if (state.head == 0)
+                recomputeSum(config, state);
+        }
+
+        static void recomputeSum(const Config& config, State& state) {
+            state.sum = 0;
+            for (size_t i = 0; i < config.bucketCount; i++)
+                state.sum += state.buckets[i];
+        }
+
+        Config config;
+        State state;
+    };
+
+    /**
+     * @brief Detection of leaks based on flood signals from a specific probe.
+     *
+     * If the specified probe has emitted a signal, the CLOSE_VALVE action is taken.
+     */
+    class ProbeLeakDetectionCriterion final : public LeakDetectionCriterion {
+    public:
+        /**
+         * @brief The criterion has no parameters; the type only selects it in SharedCriteria.
+         */
+        struct Config {
+            using Criterion = ProbeLeakDetectionCriterion;
+        };
+
+        /**
+         * @brief Runtime state of the criterion.
+         */
+        struct State {
+            uint8_t probeId {};
+            bool leakDetected = false;
+        };
+
+        [[nodiscard]] const State& getState() const { return state; }
+
+        void update(const SensorState& sensorState, const time_t elapsedTime) override {
+            advance(Config {}, state, sensorState, elapsedTime);
+        }
+
+        void advance(const SensorState& sensorState, const time_t duration) override {
+            advance(Config {}, state, sensorState, duration);
+        }
+
+        static void advance(const Config&, State& state, const SensorState& sensorState, time_t) {
+            const int firstWet = sensorState.probeStates.findFirst();
+            state.leakDetected = firstWet >= 0;
+            if (state.leakDetected) {
+                state.probeId = static_cast<uint8_t>(firstWet);
+            }
+        }
+
+        bool updatePulses(const PulseCalibration& calibration, const uint32_t pulses, const time_t elapsedTime) override {
+            return updatePulses(Config {}, state, calibration, pulses, elapsedTime);
+        }
+
+        static bool updatePulses(const Config&, State&, const PulseCalibration&, uint32_t, time_t) {
+            // Probe states do not change with pulse samples
+            return true;
+        }
+
+        [[nodiscard]] time_t timeUntilAction() const override {
+            return timeUntilAction(Config {}, state);
+        }
+
+        static time_t timeUntilAction(const Config&, const State& state) {
+            return state.leakDetected ? 0 : NEVER;
+        }
+
+        /**
+         * @brief Apply a single probe change without rescanning unaffected probes.
+         *
+         * @param probeStates Probe states, already including the change.
+         * @param changedProbeId The probe that changed state.
+         * @param wet Whether the probe now detects a leak.
+         */
+        void onProbeChanged(const ProbeMask& probeStates, const uint8_t changedProbeId, const bool wet) override {
+            onProbeChanged(state, probeStates, changedProbeId, wet);
+        }
+
+        static void onProbeChanged(State& state, const ProbeMask& probeStates, const uint8_t changedProbeId, const bool wet) {
+            if (wet) {
+                if (!state.leakDetected || changedProbeId < state.probeId) {
+                    state.probeId = changedProbeId;
+                    state.leakDetected = true;
+                }
+            }
+            else if (state.leakDetected && changedProbeId == state.probeId) {
+                const int firstWet = probeStates.findFirst();
+                state.leakDetected = firstWet >= 0;
+                if (state.leakDetected) {
+                    state.probeId = static_cast<uint8_t>(firstWet);
                 }
             }
         }
 
+        [[nodiscard]] std::optional<LeakPreventionAction> getAction() const override {
+            return getAction(Config {}, state);
+        }
+
+        static std::optional<LeakPreventionAction> getAction(const Config&, const State& state) {
+            if (state.leakDetected) {
+                return LeakPreventionAction(
+                    ActionType::CLOSE_VALVE,
+                    ActionReason::LEAK_DETECTED_BY_PROBE,
+                    state.probeId
+                );
+            }
+            return std::nullopt;
+        }
+
+        [[nodiscard]] StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH> serialize() const override {
+            StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH> serialized;
+            serialized += StaticString<8>("P,");
+
+            return serialized;
+        }
+
+        static std::unique_ptr<ProbeLeakDetectionCriterion> deserialize(const StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH>& serialized) {
+            ParsedCriterion parsed;
+            if (!ConfigParser::parseRecord(std::string_view(serialized.ToCStr(), serialized.GetLength()), parsed)
+                || parsed.type != 'P')
+                return nullptr;
+
+            return std::make_unique<ProbeLeakDetectionCriterion>();
+        }
+
+        void serializeBinary(BinaryWriter& writer) const override {
+            writer.beginRecord('P');
+            writer.endRecord();
+        }
+
+        void saveState(BinaryWriter& writer) const override {
+            saveState(state, writer);
+        }
+
+        static void saveState(const State& state, BinaryWriter& writer) {
+            writer.writeU8(state.probeId);
+            writer.writeU8(state.leakDetected);
+        }
+
+        bool restoreState(BinaryReader& reader) override {
+            return restoreState(state, reader);
+        }
+
+        static bool restoreState(State& state, BinaryReader& reader) {
+            const uint8_t restoredProbeId = reader.readU8();
+            const bool restoredLeakDetected = reader.readU8() != 0;
+            if (!reader.isValid())
+                return false;
+
+            state.probeId = restoredProbeId;
+            state.leakDetected = restoredLeakDetected;
+            return true;
+        }
+
+    private:
+        State state;
+    };
+
+    /**
+     * @brief Storage for a single leak detection criterion.
+     *
+     * Criteria created with emplace() are constructed in an aligned in-place buffer, so no heap
+     * allocation takes place. A criterion handed over as a unique_ptr is adopted as-is and
+     * released with delete.
+     */
+    class CriterionSlot {
+    public:
+        static constexpr size_t SIZE = LEAK_LOGIC_CRITERION_SLOT_SIZE;
+
+        CriterionSlot() = default;
+
+        explicit CriterionSlot(std::unique_ptr<LeakDetectionCriterion> criterion)
+            : criterion(criterion.release()) {}
+
+        CriterionSlot(CriterionSlot&& other) noexcept {
+            moveFrom(other);
+        }
+
+        CriterionSlot& operator=(CriterionSlot&& other) noexcept {
+            if (this != &other) {
+                reset();
+                moveFrom(other);
+            }
+            return *this;
+        }
+
+        CriterionSlot(const CriterionSlot&) = delete;
+        CriterionSlot& operator=(const CriterionSlot&) = delete;
+
+        ~CriterionSlot() { reset(); }
+
+        /**
+         * @brief Construct a criterion in the in-place buffer, destroying the current one.
+         */
+        template <typename T, typename... Args>
+        T& emplace(Args&&... args) {
+            static_assert(std::is_base_of_v<LeakDetectionCriterion, T>, "T must be a LeakDetectionCriterion");
+            static_assert(sizeof(T) <= SIZE, "Criterion does not fit in LEAK_LOGIC_CRITERION_SLOT_SIZE");
+            static_assert(alignof(T) <= alignof(std::max_align_t), "Criterion is over-aligned");
+            static_assert(std::is_nothrow_move_constructible_v<T>, "Criterion must be nothrow move constructible");
+
+            reset();
+            T* object = new (storage) T(std::forward<Args>(args)...);
+            criterion = object;
+            relocate = &relocateImpl<T>;
+            return *object;
+        }
+
+        void reset() {
+            if (criterion == nullptr)
+                return;
+
+            if (isInPlace())
+                criterion->~LeakDetectionCriterion();
+            else
+                delete criterion;
+
+            criterion = nullptr;
+            relocate = nullptr;
+        }
+
+        /**
+         * @brief Whether the criterion lives in the in-place buffer (as opposed to the heap).
+         */
+        [[nodiscard]] bool isInPlace() const { return relocate != nullptr; }
+
+        [[nodiscard]] LeakDetectionCriterion* get() const { return criterion; }
+        LeakDetectionCriterion* operator->() const { return criterion; }
+        LeakDetectionCriterion& operator*() const { return *criterion; }
+        explicit operator bool() const { return criterion != nullptr; }
 
     private:
-        StaticVector<std::unique_ptr<LeakDetectionCriterion>, LEAK_LOGIC_MAX_CRITERIA> criteria;
-        ProbeLeakDetectionCriterion probeLeakCriterion;
+        using Relocator = LeakDetectionCriterion* (*)(void* destination, LeakDetectionCriterion* source);
+
+        template <typename T>
+        static LeakDetectionCriterion* relocateImpl(void* destination, LeakDetectionCriterion* source) {
+            T* typedSource = static_cast<T*>(source);
+            T* moved = new (destination) T(std::move(*typedSource));
+            typedSource->~T();
+            return moved;
+        }
+
+        void moveFrom(CriterionSlot& other) {
+            if (other.isInPlace())
+                criterion = other.relocate(storage, other.criterion);
+            else
+                criterion = other.criterion;
+
+            relocate = other.relocate;
+            other.criterion = nullptr;
+            other.relocate = nullptr;
+        }
+
+        alignas(std::max_align_t) unsigned char storage[SIZE];
+        LeakDetectionCriterion* criterion = nullptr;
+        Relocator relocate = nullptr;
+    };
+
+    /**
+     * @brief Ordered list of leak detection criteria, loadable from and storable to the configuration formats.
+     *
+     * LeakLogic evaluates one. A replacement can be built on another thread and handed over with
+     * LeakLogic::publishCriteria().
+     */
+    class CriteriaSet {
+    public:
+        using Iterator = StaticVector<CriterionSlot, LEAK_LOGIC_MAX_CRITERIA>::Iterator;
+
+        CriteriaSet() = default;
+        CriteriaSet(const CriteriaSet&) = delete;
+        CriteriaSet& operator=(const CriteriaSet&) = delete;
+
+        /**
+         * @param criterion A unique_ptr to a leak detection criterion object.
+         * @return Whether the criterion was added successfully.
+         */
+        bool addCriterion(std::unique_ptr<LeakDetectionCriterion> criterion) {
+            if (!criterion)
+                return false;
+
+            return criteria.Append(CriterionSlot(std::move(criterion)));
+        }
+
+        /**
+         * @brief Construct a criterion in place, without heap allocation.
+         *
+         * @param args Arguments forwarded to the constructor of T.
+         * @return Whether the criterion was added successfully.
+         */
+        template <typename T, typename... Args>
+        bool emplaceCriterion(Args&&... args) {
+            if (!criteria.Append(CriterionSlot()))
+                return false;
+
+            criteria[criteria.GetSize() - 1].template emplace<T>(std::forward<Args>(args)...);
+            return true;
+        }
+
+        /**
+         * @brief Add a criterion from a parsed text record, without heap allocation.
+         *
+         * Unknown criteria, e.g. written by newer firmware, are skipped, as by loadFromBinary().
+         *
+         * @return Whether the record was accepted: added, or skipped as unknown. False if a known
+         *         criterion had invalid fields or the list is full.
+         */
+        bool addParsedCriterion(const ParsedCriterion& parsed) {
+            switch (parsed.type) {
+                case 'T': {
+                    FlowRate rateThreshold;
+                    time_t minDuration;
+                    return TimeBasedFlowRateCriterion::fromParsed(parsed, rateThreshold, minDuration)
+                        && emplaceCriterion<TimeBasedFlowRateCriterion>(rateThreshold, minDuration);
+                }
+                case 'V': {
+                    Volume maxVolume;
+                    time_t window;
+                    time_t bucketWidth;
+                    return VolumeWindowCriterion::fromParsed(parsed, maxVolume, window, bucketWidth)
+                        && emplaceCriterion<VolumeWindowCriterion>(maxVolume, window, bucketWidth);
+                }
+                case 'P':
+                    return parsed.fieldCount == 0 && emplaceCriterion<ProbeLeakDetectionCriterion>();
+                default:
+                    return true;
+            }
+        }
+
+        /**
+         * @brief Replace the criteria with the ones from a text configuration.
+         *
+         * Criteria parsed before an error are kept.
+         *
+         * @return The parse result, with the byte offset of the first error.
+         */
+        ParseResult loadFromString(const StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH>& serialized) {
+            clear();
+
+            ConfigParser parser;
+            parser.feed(std::string_view(serialized.ToCStr(), serialized.GetLength()),
+                [this](const ParsedCriterion& parsed) { return addParsedCriterion(parsed); });
+            return parser.finish();
+        }
+
+        /**
+         * @brief Replace the criteria with the ones from a binary configuration, read in place.
+         *
+         * @return Whether the configuration was valid. If it was not, the criteria are left untouched.
+         */
+        bool loadFromBinary(const BinaryConfigView& config) {
+            if (!config.isValid())
+                return false;
+
+            clear();
+
+            for (const auto record : config) {
+                if (!criteria.Append(CriterionSlot()))
+                    break;
+                if (!emplaceRecord(criteria[criteria.GetSize() - 1], record))
+                    criteria.RemoveIndex(static_cast<uint8_t>(criteria.GetSize() - 1));
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Apply a binary patch (see BinaryPatchView) in place. Criteria the patch does not add or
+         * replace keep their runtime state.
+         *
+         * @return Whether the patch was valid, made for the current configuration, and applied. If not, the
+         *         criteria are left untouched.
+         */
+        bool applyPatch(const BinaryPatchView& patch) {
+            if (!patch.isValid() || patch.getBaseHash() != getConfigHash())
+                return false;
+
+            // Check every operation first, so a bad patch never leaves a half-applied configuration
+            size_t size = getSize();
+            for (const auto operation : patch) {
+                switch (operation.operation) {
+                    case PatchOperation::ADD:
+                        if (operation.index > size || size == LEAK_LOGIC_MAX_CRITERIA
+                            || !isValidRecord(operation.record))
+                            return false;
+                        size++;
+                    break;
+                    case PatchOperation::REMOVE:
+                        if (operation.index >= size)
+                            return false;
+                        size--;
+                    break;
+                    case PatchOperation::REPLACE:
+                        if (operation.index >= size || !isValidRecord(operation.record))
+                            return false;
+                    break;
+                }
+            }
+
+            for (const auto operation : patch) {
+                switch (operation.operation) {
+                    case PatchOperation::ADD:
+                        criteria.Append(CriterionSlot());
+                        emplaceRecord(criteria[criteria.GetSize() - 1], operation.record);
+                        for (size_t i = criteria.GetSize() - 1; i > operation.index; i--)
+                            std::swap(criteria[i], criteria[i - 1]);
+                    break;
+                    case PatchOperation::REMOVE:
+                        criteria.RemoveIndex(operation.index);
+                    break;
+                    case PatchOperation::REPLACE:
+                        emplaceRecord(criteria[operation.index], operation.record);
+                    break;
+                }
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Hash of the configuration: the CRC-32 of its binary form, the same as BinaryConfigView::getCrc().
+         *
+         * Lets a configuration server skip pushing a configuration the device already has.
+         *
+         * @return The hash, or 0 if the binary configuration is longer than LEAK_LOGIC_MAX_SERIALIZE_LENGTH.
+         */
+        [[nodiscard]] uint32_t getConfigHash() const {
+            uint8_t buffer[LEAK_LOGIC_MAX_SERIALIZE_LENGTH];
+            const size_t length = serializeBinary(buffer, sizeof(buffer));
+            return length == 0 ? 0 : BinaryConfigView(buffer, length).getCrc();
+        }
+
+        [[nodiscard]] StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH> serialize() const {
+            StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH> serialized;
+
+            for (const auto& criterion : criteria) {
+                serialized += criterion->serialize();
+                serialized += StaticString<1>("|");
+            }
+
+            return serialized;
+        }
+
+        /**
+         * @brief Serialize the criteria in the binary configuration format (see BinaryConfigView).
+         *
+         * @return Number of bytes written, or 0 if the buffer was too small.
+         */
+        size_t serializeBinary(uint8_t* buffer, const size_t capacity) const {
+            BinaryWriter writer(buffer, capacity);
+            writer.writeU8('L');
+            writer.writeU8('G');
+            writer.writeU8(LEAK_LOGIC_BINARY_VERSION);
+            writer.writeU8(static_cast<uint8_t>(criteria.GetSize()));
+
+            for (const auto& criterion : criteria) {
+                criterion->serializeBinary(writer);
+            }
+
+            if (writer.isOverflow())
+                return 0;
+
+            writer.writeU32(crc32(buffer, writer.getLength()));
+            return writer.isOverflow() ? 0 : writer.getLength();
+        }
+
+        bool removeCriterion(const uint8_t index) {
+            return criteria.RemoveIndex(index);
+        }
+
+        void clear() {
+            criteria.Clear();
+        }
+
+        [[nodiscard]] size_t getSize() const { return criteria.GetSize(); }
+
+        CriterionSlot& operator[](const size_t index) { return criteria[index]; }
+        const CriterionSlot& operator[](const size_t index) const { return criteria[index]; }
+
+        Iterator begin() { return criteria.begin(); }
+        Iterator end() { return criteria.end(); }
+        auto begin() const { return criteria.begin(); }
+        auto end() const { return criteria.end(); }
+
+        /**
+         * @brief Call f with each criterion in order, see LeakEvaluator.
+         */
+        template <typename F>
+        void forEach(F&& f) {
+            for (const auto& criterion : criteria)
+                f(*criterion);
+        }
+
+        template <typename F>
+        void forEach(F&& f) const {
+            for (const auto& criterion : criteria)
+                f(static_cast<const LeakDetectionCriterion&>(*criterion));
+        }
+
+        /**
+         * @brief Whether two criteria are of the same type and have the same parameters.
+         */
+        static bool isSameConfiguration(const LeakDetectionCriterion& a, const LeakDetectionCriterion& b) {
+            uint8_t recordA[32];
+            uint8_t recordB[32];
+            BinaryWriter writerA(recordA, sizeof(recordA));
+            BinaryWriter writerB(recordB, sizeof(recordB));
+            a.serializeBinary(writerA);
+            b.serializeBinary(writerB);
+
+            return !writerA.isOverflow() && !writerB.isOverflow() && writerA.getLength() == writerB.getLength()
+                && std::memcmp(recordA, recordB, writerA.getLength()) == 0;
+        }
+
+        /**
+         * @brief Take over the criteria (with their runtime state) of previous that are configured the same
+         * as one of ours, giving ours to previous in exchange. Each criterion is matched at most once.
+         */
+        void adoptStateFrom(CriteriaSet& previous) {
+            bool matched[LEAK_LOGIC_MAX_CRITERIA] {};
+
+            for (auto& criterion : criteria) {
+                for (size_t i = 0; i < previous.getSize(); i++) {
+                    if (!matched[i] && isSameConfiguration(*criterion, *previous[i])) {
+                        std::swap(criterion, previous[i]);
+                        matched[i] = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Exchange the criteria of both sets. Criteria are relocated, not reconstructed.
+         */
+        void swap(CriteriaSet& other) {
+            const size_t common = getSize() < other.getSize() ? getSize() : other.getSize();
+            for (size_t i = 0; i < common; i++)
+                std::swap(criteria[i], other.criteria[i]);
+
+            CriteriaSet& longer = getSize() > common ? *this : other;
+            CriteriaSet& shorter = getSize() > common ? other : *this;
+            while (longer.getSize() > common) {
+                shorter.criteria.Append(std::move(longer.criteria[common]));
+                longer.criteria.RemoveIndex(static_cast<uint8_t>(common));
+            }
+        }
+
+    private:
+        friend class LeakLogic;
+
+        /**
+         * @brief Construct the criterion described by a binary record in slot.
+         *
+         * @return Whether the record described a known criterion. If not, slot is left untouched.
+         */
+        static bool emplaceRecord(CriterionSlot& slot, const BinaryConfigView::Record& record) {
+            switch (record.type) {
+                case 'T': {
+                    FlowRate rateThreshold;
+                    time_t minDuration;
+                    if (!TimeBasedFlowRateCriterion::parseBinary(record, rateThreshold, minDuration))
+                        return false;
+                    slot.emplace<TimeBasedFlowRateCriterion>(rateThreshold, minDuration);
+                    return true;
+                }
+                case 'V': {
+                    Volume maxVolume;
+                    time_t window;
+                    time_t bucketWidth;
+                    if (!VolumeWindowCriterion::parseBinary(record, maxVolume, window, bucketWidth))
+                        return false;
+                    slot.emplace<VolumeWindowCriterion>(maxVolume, window, bucketWidth);
+                    return true;
+                }
+                case 'P':
+                    slot.emplace<ProbeLeakDetectionCriterion>();
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        static bool isValidRecord(const BinaryConfigView::Record& record) {
+            CriterionSlot scratch;
+            return emplaceRecord(scratch, record);
+        }
+
+        StaticVector<CriterionSlot, LEAK_LOGIC_MAX_CRITERIA> criteria;
+
+        /**
+         * @brief Link of the list of sets retired by LeakLogic, waiting to be reclaimed.
+         */
+        CriteriaSet* nextRetired = nullptr;
+    };
+
+    /**
+     * @brief Status of a single criterion within a LeakLogicSnapshot.
+     */
+    struct CriterionSnapshot {
+        /**
+         * @brief The action the criterion takes, NO_ACTION if none.
+         */
+        LeakPreventionAction action = LeakPreventionAction(ActionType::NO_ACTION);
+        time_t timeUntilAction = LeakDetectionCriterion::NEVER;
+        int32_t accumulated = 0;
+    };
+
+    /**
+     * @brief Copy of the decision state of a LeakLogic, meant to be published to other threads, e.g.
+     * through a SeqLock.
+     */
+    struct LeakLogicSnapshot {
+        LeakPreventionAction action = LeakPreventionAction(ActionType::NO_ACTION);
+        uint32_t actionGeneration = 0;
+        FlowRate flowRate = 0;
+        ProbeMask probeStates;
+        uint8_t criterionCount = 0;
+        CriterionSnapshot criteria[LEAK_LOGIC_MAX_CRITERIA];
+    };
+
+    /**
+     * @brief A single sensor event, as queued by interrupt handlers for LeakLogic::drain().
+     */
+    struct SensorSample {
+        enum class Type : uint8_t {
+            FLOW_RATE,
+            PULSES,
+            PROBE
+        };
+
+        static SensorSample ofFlowRate(const FlowRate flowRate, const uint32_t elapsedTime) {
+            SensorSample sample;
+            sample.type = Type::FLOW_RATE;
+            sample.flowRate = flowRate;
+            sample.elapsedTime = elapsedTime;
+            return sample;
+        }
+
+        static SensorSample ofPulses(const uint32_t pulses, const uint32_t elapsedTime) {
+            SensorSample sample;
+            sample.type = Type::PULSES;
+            sample.pulses = pulses;
+            sample.elapsedTime = elapsedTime;
+            return sample;
+        }
+
+        static SensorSample ofProbe(const uint8_t probeId, const bool wet) {
+            SensorSample sample;
+            sample.type = Type::PROBE;
+            sample.probeId = probeId;
+            sample.wet = wet;
+            return sample;
+        }
+
+        Type type = Type::FLOW_RATE;
+        uint8_t probeId = 0;
+        bool wet = false;
+
+        /**
+         * @brief Time in seconds since the previous flow sample. Unused for probe events.
+         */
+        uint32_t elapsedTime = 0;
+        FlowRate flowRate = 0;
+        uint32_t pulses = 0;
+    };
+
+    template <size_t Capacity>
+    class SampleRing;
+
+    /**
+     * @brief Runtime state of a leak logic besides its criteria.
+     */
+    struct LeakLogicState {
+        /**
+         * @brief The last known sensor state.
+         */
+        SensorState sensorState;
+
+        /**
+         * @brief State of the built-in probe criterion, which acts on any wet probe.
+         */
+        ProbeLeakDetectionCriterion::State probe;
+
+        /**
+         * @brief Flow meter calibration, see LeakLogic::setPulseCalibration().
+         */
+        PulseCalibration calibration;
+    };
+
+    /**
+     * @brief Sensor input dispatch and action aggregation over an ordered list of criteria, shared by
+     * LeakLogic, LeakLogicT and SharedLeakLogic.
+     *
+     * Criteria must have forEach(f), calling f with each criterion in order as an object with the
+     * update(), advance(), updatePulses(), onProbeChanged(), getAction() and timeUntilAction() members
+     * of LeakDetectionCriterion. The first criterion taking action wins; the built-in probe criterion
+     * comes last.
+     */
+    class LeakEvaluator {
+    public:
+        template <typename Criteria>
+        static void update(Criteria& criteria, LeakLogicState& state, const SensorState& sensorState,
+                           const time_t elapsedTime) {
+            state.sensorState = sensorState;
+            criteria.forEach([&](auto&& criterion) { criterion.update(sensorState, elapsedTime); });
+            ProbeLeakDetectionCriterion::advance({}, state.probe, sensorState, elapsedTime);
+        }
+
+        template <typename Criteria>
+        static void advance(Criteria& criteria, LeakLogicState& state, const SensorState& sensorState,
+                            const time_t duration) {
+            state.sensorState = sensorState;
+            criteria.forEach([&](auto&& criterion) { criterion.advance(sensorState, duration); });
+            ProbeLeakDetectionCriterion::advance({}, state.probe, sensorState, duration);
+        }
+
+        template <typename Criteria>
+        static void onProbeChanged(Criteria& criteria, LeakLogicState& state, const uint8_t probeId, const bool wet) {
+            state.sensorState.probeStates.set(probeId, wet);
+            ProbeLeakDetectionCriterion::onProbeChanged(state.probe, state.sensorState.probeStates, probeId, wet);
+            criteria.forEach([&](auto&& criterion) {
+                criterion.onProbeChanged(state.sensorState.probeStates, probeId, wet);
+            });
+        }
+
+        template <typename Criteria>
+        static void onFlowSample(Criteria& criteria, LeakLogicState& state, const FlowRate flowRate,
+                                 const time_t elapsedTime) {
+            state.sensorState.flowRate = flowRate;
+            criteria.forEach([&](auto&& criterion) { criterion.update(state.sensorState, elapsedTime); });
+        }
+
+        /**
+         * @brief Criteria without a pulse path get the equivalent flow rate. The flow rate of the sensor
+         * state is not updated.
+         */
+        template <typename Criteria>
+        static void onPulseSample(Criteria& criteria, LeakLogicState& state, const uint32_t pulses,
+                                  const time_t elapsedTime) {
+            std::optional<SensorState> converted;
+            criteria.forEach([&](auto&& criterion) {
+                if (criterion.updatePulses(state.calibration, pulses, elapsedTime))
+                    return;
+
+                if (!converted) {
+                    converted = state.sensorState;
+                    converted->flowRate = flowRateFromPulses(pulses, elapsedTime, state.calibration.pulsesPerLiter);
+                }
+                criterion.update(*converted, elapsedTime);
+            });
+        }
+
+        template <typename Criteria>
+        [[nodiscard]] static LeakPreventionAction getAction(const Criteria& criteria, const LeakLogicState& state) {
+            std::optional<LeakPreventionAction> action;
+            criteria.forEach([&](const auto& criterion) {
+                if (!action)
+                    action = criterion.getAction();
+            });
+
+            if (action)
+                return *action;
+
+            if (const auto probeAction = ProbeLeakDetectionCriterion::getAction({}, state.probe))
+                return probeAction.value();
+
+            return LeakPreventionAction(ActionType::NO_ACTION);
+        }
+
+        template <typename Criteria>
+        [[nodiscard]] static time_t timeUntilNextPossibleAction(const Criteria& criteria, const LeakLogicState& state) {
+            time_t earliest = ProbeLeakDetectionCriterion::timeUntilAction({}, state.probe);
+            criteria.forEach([&](const auto& criterion) {
+                const time_t remaining = criterion.timeUntilAction();
+                if (remaining < earliest)
+                    earliest = remaining;
+            });
+            return earliest;
+        }
+    };
+
+    /**
+     * @brief Leak detection logic.
+     */
+    class LeakLogic {
+    public:
+        /**
+         * @brief Get the global logic singleton.
+         */
+        static LeakLogic& getInstance() {
+            static LeakLogic instance;
+            return instance;
+        }
+
+        LeakLogic() = default;
+        LeakLogic(const LeakLogic&) = delete;
+        LeakLogic& operator=(const LeakLogic&) = delete;
+
+        ~LeakLogic() {
+            delete publishedCriteria.load(std::memory_order_acquire);
+            reclaimRetiredCriteria();
+        }
+
+        /**
+         * @brief Update the leak logic with the current sensor state and time elapsed since the last update.
+         *
+         * @param sensorState The current sensor state.
+         * @param elapsedTime Time in seconds since the last update.
+         */
+        void update(const SensorState& sensorState, const time_t elapsedTime) {
+            adoptPublishedCriteria();
+            LeakEvaluator::update(criteria, state, sensorState, elapsedTime);
+            refreshAction();
+        }
+
+        /**
+         * @brief Fast-forward the leak logic over a span of constant sensor input, e.g. after a deep sleep.
+         *
+         * Equivalent to calling update() in a loop of smaller steps adding up to duration, but takes
+         * time independent of the duration.
+         *
+         * @param sensorState The sensor state throughout the span.
+         * @param duration Length of the span, in seconds.
+         */
+        void advance(const SensorState& sensorState, const time_t duration) {
+            adoptPublishedCriteria();
+            LeakEvaluator::advance(criteria, state, sensorState, duration);
+            refreshAction();
+        }
+
+        /**
+         * @brief Inform the leak logic that a single probe changed state.
+         *
+         * Only the changed probe is inspected, so this can be called directly from a radio receive handler.
+         *
+         * @param probeId The probe that changed state.
+         * @param wet Whether the probe now detects a leak.
+         */
+        void onProbeChanged(const uint8_t probeId, const bool wet) {
+            adoptPublishedCriteria();
+            LeakEvaluator::onProbeChanged(criteria, state, probeId, wet);
+            refreshAction();
+        }
+
+        /**
+         * @brief Update the leak logic with a new flow rate sample, keeping the last known probe states.
+         *
+         * @param flowRate Water flow rate, in liters per minute.
+         * @param elapsedTime Time in seconds since the last update.
+         */
+        void onFlowSample(const FlowRate flowRate, const time_t elapsedTime) {
+            adoptPublishedCriteria();
+            LeakEvaluator::onFlowSample(criteria, state, flowRate, elapsedTime);
+            refreshAction();
+        }
+
+        /**
+         * @brief Set the calibration constant of a pulse-counting flow meter, for use with onPulseSample().
+         *
+         * The volume per pulse is computed once here, and criteria compare pulse counts with their
+         * integer thresholds, so pulse samples need neither division nor floating point.
+         *
+         * @param pulsesPerLiter Flow meter pulses per liter, or 0 to disable pulse input.
+         */
+        void setPulseCalibration(const uint32_t pulsesPerLiter) {
+            state.calibration = PulseCalibration(pulsesPerLiter);
+        }
+
+        [[nodiscard]] uint32_t getPulseCalibration() const { return state.calibration.pulsesPerLiter; }
+
+        /**
+         * @brief Update the leak logic with a raw flow meter pulse count, keeping the last known probe states.
+         *
+         * Criteria without a pulse path get the equivalent flow rate. The flow rate of getSensorState() is
+         * not updated by pulse samples.
+         *
+         * The built-in criteria need no division for a sample, except VolumeWindowCriterion once whenever
+         * the sample period changes. Criteria without a pulse path (and all criteria while no calibration
+         * is set) go through flowRateFromPulses(), which does divide.
+         *
+         * @param pulses Pulses counted since the last update.
+         * @param elapsedTime Time in seconds since the last update.
+         */
+        void onPulseSample(const uint32_t pulses, const time_t elapsedTime) {
+            adoptPublishedCriteria();
+            LeakEvaluator::onPulseSample(criteria, state, pulses, elapsedTime);
+            refreshAction();
+        }
+
+        /**
+         * @brief Apply all samples queued by interrupt handlers, in order, as one batch.
+         *
+         * Must be called from the single consumer of the ring, usually the main loop. The action is
+         * evaluated once for the whole batch.
+         *
+         * @return Number of samples applied.
+         */
+        template <size_t Capacity>
+        size_t drain(SampleRing<Capacity>& ring) {
+            adoptPublishedCriteria();
+            const size_t count = ring.consume([this](const SensorSample& sample) {
+                switch (sample.type) {
+                    case SensorSample::Type::FLOW_RATE:
+                        LeakEvaluator::onFlowSample(criteria, state, sample.flowRate, sample.elapsedTime);
+                        break;
+                    case SensorSample::Type::PULSES:
+                        LeakEvaluator::onPulseSample(criteria, state, sample.pulses, sample.elapsedTime);
+                        break;
+                    case SensorSample::Type::PROBE:
+                        LeakEvaluator::onProbeChanged(criteria, state, sample.probeId, sample.wet);
+                        break;
+                }
+            });
+
+            if (count > 0)
+                refreshAction();
+            return count;
+        }
+
+        /**
+         * @brief The last known sensor state, from update() or the incremental sensor events.
+         */
+        [[nodiscard]] const SensorState& getSensorState() const { return state.sensorState; }
+
+        /**
+         * @brief Get the action determined by specified leak detection criteria.
+         *
+         * The action is evaluated whenever the sensor state or the criteria change, so this only reads it.
+         */
+        [[nodiscard]] LeakPreventionAction getAction() const {
+            return cachedAction;
+        }
+
+        /**
+         * @brief Counter incremented whenever the action returned by getAction() changes.
+         *
+         * Consumers polling every tick can compare it with the last value they saw instead of the action.
+         */
+        [[nodiscard]] uint32_t getActionGeneration() const {
+            return actionGeneration;
+        }
+
+        /**
+         * @brief Copy the aggregated action, sensor state and per-criterion status.
+         *
+         * Meant to be published through a SeqLock after each update, so other threads can read the state
+         * without locking the logic.
+         */
+        [[nodiscard]] LeakLogicSnapshot getSnapshot() const {
+            LeakLogicSnapshot snapshot;
+            snapshot.action = cachedAction;
+            snapshot.actionGeneration = actionGeneration;
+            snapshot.flowRate = state.sensorState.flowRate;
+            snapshot.probeStates = state.sensorState.probeStates;
+
+            for (const auto& criterion : criteria) {
+                CriterionSnapshot& entry = snapshot.criteria[snapshot.criterionCount++];
+                if (const auto action = criterion->getAction())
+                    entry.action = *action;
+                entry.timeUntilAction = criterion->timeUntilAction();
+                entry.accumulated = criterion->getAccumulated();
+            }
+            return snapshot;
+        }
+
+        /**
+         * @brief Re-evaluate the action. Only needed after changing criteria directly through getCriteria().
+         */
+        void refreshAction() {
+            const LeakPreventionAction action = evaluateAction();
+            if (action != cachedAction) {
+                cachedAction = action;
+                actionGeneration++;
+            }
+        }
+
+        /**
+         * @brief Time in seconds until any criterion could take action, if the sensors keep their last state.
+         *
+         * A controller can sleep this long, or until a sensor interrupt, instead of updating periodically.
+         *
+         * @return 0 if an action is taken already, LeakDetectionCriterion::NEVER if no criterion can take
+         *         action without a sensor change.
+         */
+        [[nodiscard]] time_t timeUntilNextPossibleAction() const {
+            return LeakEvaluator::timeUntilNextPossibleAction(criteria, state);
+        }
+
+        /**
+         * @brief Add a criterion for leak detection.
+         *
+         * @param criterion A unique_ptr to a leak detection criterion object.
+         * @return Whether the criterion was added successfully.
+         */
+        bool addCriterion(std::unique_ptr<LeakDetectionCriterion> criterion) {
+            if (!criteria.addCriterion(std::move(criterion)))
+                return false;
+
+            refreshAction();
+            return true;
+        }
+
+        /**
+         * @brief Construct a criterion for leak detection in place, without heap allocation.
+         *
+         * @param args Arguments forwarded to the constructor of T.
+         * @return Whether the criterion was added successfully.
+         */
+        template <typename T, typename... Args>
+        bool emplaceCriterion(Args&&... args) {
+            if (!criteria.emplaceCriterion<T>(std::forward<Args>(args)...))
+                return false;
+
+            refreshAction();
+            return true;
+        }
+
+        /**
+         * @brief Gets an iterator for the leak detection criteria list.
+         */
+        CriteriaSet::Iterator getCriteria() {
+            return criteria.begin();
+        }
+
+        /**
+         * @brief Removes a criterion for leak detection from the list.
+         *
+         * @param index Index of the criterion to remove.
+         * @return Whether the criterion was removed successfully.
+         */
+        bool removeCriterion(const uint8_t index) {
+            if (!criteria.removeCriterion(index))
+                return false;
+
+            refreshAction();
+            return true;
+        }
+
+        void clearCriteria() {
+            criteria.clear();
+            refreshAction();
+        }
+
+        [[nodiscard]] StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH> serialize() const {
+            return criteria.serialize();
+        }
+
+        /**
+         * @brief Replace the criteria with the ones from a text configuration.
+         *
+         * Criteria parsed before an error are kept.
+         *
+         * @return The parse result, with the byte offset of the first error.
+         */
+        ParseResult loadFromString(const StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH>& serialized) {
+            const ParseResult result = criteria.loadFromString(serialized);
+            refreshAction();
+            return result;
+        }
+
+        /**
+         * @brief Add a criterion from a parsed text record, without heap allocation.
+         *
+         * Use as the ConfigParser record handler to load a configuration arriving in chunks.
+         *
+         * @return Whether the record was accepted, see CriteriaSet::addParsedCriterion().
+         */
+        bool addParsedCriterion(const ParsedCriterion& parsed) {
+            const size_t size = criteria.getSize();
+            if (!criteria.addParsedCriterion(parsed))
+                return false;
+
+            if (criteria.getSize() > size)
+                refreshAction();
+            return true;
+        }
+
+        /**
+         * @brief Serialize the criteria in the binary configuration format (see BinaryConfigView).
+         *
+         * @param buffer Output buffer.
+         * @param capacity Size of the output buffer.
+         * @return Number of bytes written, or 0 if the buffer was too small.
+         */
+        size_t serializeBinary(uint8_t* buffer, const size_t capacity) const {
+            return criteria.serializeBinary(buffer, capacity);
+        }
+
+        /**
+         * @brief Replace the criteria with the ones from a binary configuration, read in place.
+         *
+         * @return Whether the configuration was valid. If it was not, the criteria are left untouched.
+         */
+        bool loadFromBinary(const BinaryConfigView& config) {
+            if (!criteria.loadFromBinary(config))
+                return false;
+
+            refreshAction();
+            return true;
+        }
+
+        bool loadFromBinary(const uint8_t* data, const size_t size) {
+            return loadFromBinary(BinaryConfigView(data, size));
+        }
+
+        /**
+         * @brief Apply a binary patch (see BinaryPatchView) in place, e.g. to change a single threshold.
+         *
+         * Criteria the patch does not add or replace keep their runtime state.
+         *
+         * @return Whether the patch was valid, made for the current configuration (see getConfigHash()),
+         *         and applied. If not, the criteria are left untouched.
+         */
+        bool applyPatch(const BinaryPatchView& patch) {
+            if (!criteria.applyPatch(patch))
+                return false;
+
+            refreshAction();
+            return true;
+        }
+
+        bool applyPatch(const uint8_t* data, const size_t size) {
+            return applyPatch(BinaryPatchView(data, size));
+        }
+
+        /**
+         * @brief Hash of the current configuration, see CriteriaSet::getConfigHash().
+         */
+        [[nodiscard]] uint32_t getConfigHash() const {
+            return criteria.getConfigHash();
+        }
+
+        /**
+         * @brief Hand a new criteria set to the evaluation thread. Safe to call while another thread updates.
+         *
+         * The set is swapped in at the start of the next update (or adoptPublishedCriteria()), so evaluation
+         * never waits for a reconfiguration. Criteria configured the same as a current one keep the current
+         * one's runtime state. A set published earlier and not adopted yet is discarded. Sets retired by
+         * the swap are freed by the next publishCriteria() or reclaimRetiredCriteria() on this thread.
+         */
+        void publishCriteria(std::unique_ptr<CriteriaSet> next) {
+            reclaimRetiredCriteria();
+            delete publishedCriteria.exchange(next.release(), std::memory_order_acq_rel);
+        }
+
+        /**
+         * @brief Free the criteria sets retired by adopted publications. Publishing thread only.
+         *
+         * @return Number of sets freed.
+         */
+        size_t reclaimRetiredCriteria() {
+            size_t count = 0;
+            CriteriaSet* retired = retiredCriteria.exchange(nullptr, std::memory_order_acquire);
+            while (retired != nullptr) {
+                CriteriaSet* next = retired->nextRetired;
+                delete retired;
+                retired = next;
+                count++;
+            }
+            return count;
+        }
+
+        /**
+         * @brief Swap in a criteria set from publishCriteria(), if there is one. Evaluation thread only.
+         *
+         * Called by every update, but can be called by an idle evaluation loop too.
+         *
+         * @return Whether a new set was adopted.
+         */
+        bool adoptPublishedCriteria() {
+            if (publishedCriteria.load(std::memory_order_relaxed) == nullptr)
+                return false;
+
+            CriteriaSet* next = publishedCriteria.exchange(nullptr, std::memory_order_acquire);
+            if (next == nullptr)
+                return false;
+
+            next->adoptStateFrom(criteria);
+            criteria.swap(*next);
+            refreshAction();
+
+            // next now holds the previous criteria, which are freed on the publishing thread
+            next->nextRetired = retiredCriteria.load(std::memory_order_relaxed);
+            while (!retiredCriteria.compare_exchange_weak(next->nextRetired, next,
+                std::memory_order_release, std::memory_order_relaxed)) {}
+            return true;
+        }
+
+        /**
+         * @brief Write a checkpoint of the configuration and the runtime state of all criteria.
+         *
+         * Layout (little-endian): magic "LC", version (u8), flags (u8), configuration length (u16),
+         * binary configuration, per criterion: state length (u8) and state, built-in probe criterion
+         * state, last known sensor state, CRC-32 of everything before it.
+         *
+         * @return Number of bytes written, or 0 if the buffer was too small.
+         */
+        size_t saveCheckpoint(uint8_t* buffer, const size_t capacity) const {
+            constexpr size_t CONFIG_OFFSET = 6;
+            if (capacity < CONFIG_OFFSET)
+                return 0;
+
+            const size_t configLength = serializeBinary(buffer + CONFIG_OFFSET, capacity - CONFIG_OFFSET);
+            if (configLength == 0)
+                return 0;
+
+            BinaryWriter header(buffer, CONFIG_OFFSET);
+            header.writeU8('L');
+            header.writeU8('C');
+            header.writeU8(LEAK_LOGIC_BINARY_VERSION);
+            header.writeU8(CHECKPOINT_FLAGS);
+            header.writeU16(static_cast<uint16_t>(configLength));
+
+            BinaryWriter writer(buffer + CONFIG_OFFSET + configLength, capacity - CONFIG_OFFSET - configLength);
+            for (const auto& criterion : criteria) {
+                const size_t lengthOffset = writer.reserveU8();
+                criterion->saveState(writer);
+                writer.patchU8(lengthOffset, static_cast<uint8_t>(writer.getLength() - lengthOffset - 1));
+            }
+            ProbeLeakDetectionCriterion::saveState(state.probe, writer);
+
+            writer.writeI32(flowRateToCenti(state.sensorState.flowRate));
+            for (const uint64_t word : state.sensorState.probeStates.getWords()) {
+                writer.writeU32(static_cast<uint32_t>(word));
+                writer.writeU32(static_cast<uint32_t>(word >> 32));
+            }
+
+            const size_t length = CONFIG_OFFSET + configLength + writer.getLength();
+            writer.writeU32(crc32(buffer, length));
+            return writer.isOverflow() ? 0 : length + 4;
+        }
+
+        /**
+         * @brief Restore the configuration and runtime state from a checkpoint written by saveCheckpoint().
+         *
+         * A corrupted checkpoint leaves the logic untouched. If only the state does not match the
+         * configuration, the configuration is loaded with fresh state, as in a newly constructed logic.
+         *
+         * @return Whether both the configuration and the state were restored.
+         */
+        bool restoreCheckpoint(const uint8_t* data, const size_t size) {
+            constexpr size_t CONFIG_OFFSET = 6;
+            if (size < CONFIG_OFFSET + 4)
+                return false;
+
+            BinaryReader header(data, CONFIG_OFFSET);
+            const bool headerValid = header.readU8() == 'L' && header.readU8() == 'C'
+                && header.readU8() == LEAK_LOGIC_BINARY_VERSION;
+            const uint8_t flags = header.readU8();
+            const size_t configLength = header.readU16();
+            if (!headerValid || CONFIG_OFFSET + configLength + 4 > size)
+                return false;
+
+            BinaryReader crcReader(data + size - 4, 4);
+            if (crcReader.readU32() != crc32(data, size - 4))
+                return false;
+
+            const BinaryConfigView config(data + CONFIG_OFFSET, configLength);
+            if (!loadFromBinary(config))
+                return false;
+
+            BinaryReader reader(data + CONFIG_OFFSET + configLength, size - 4 - CONFIG_OFFSET - configLength);
+            bool restored = true;
+            for (const auto& criterion : criteria) {
+                const uint8_t stateLength = reader.readU8();
+                BinaryReader stateReader(reader.getPosition(), stateLength < reader.getRemaining() ? stateLength : reader.getRemaining());
+                reader.skip(stateLength);
+                restored = restored && criterion->restoreState(stateReader);
+            }
+            // Staged, as the built-in criterion is not reset by loadFromBinary() if a later check fails
+            ProbeLeakDetectionCriterion::State restoredProbe;
+            restored = restored && ProbeLeakDetectionCriterion::restoreState(restoredProbe, reader);
+
+            const FlowRate restoredFlowRate = flowRateFromCenti(reader.readI32());
+            std::array<uint64_t, ProbeMask::WORD_COUNT> restoredWords {};
+            for (uint64_t& word : restoredWords) {
+                const uint64_t low = reader.readU32();
+                word = low | static_cast<uint64_t>(reader.readU32()) << 32;
+            }
+
+            if (flags != CHECKPOINT_FLAGS || !restored || !reader.isValid()) {
+                // Configuration is fine, but the state does not belong to it - start from scratch.
+                state.probe = ProbeLeakDetectionCriterion::State();
+                state.sensorState = SensorState();
+                loadFromBinary(config);
+                return false;
+            }
+
+            state.probe = restoredProbe;
+            state.sensorState = SensorState(restoredFlowRate, ProbeMask::fromWords(restoredWords));
+            refreshAction();
+            return true;
+        }
+
+    private:
+        [[nodiscard]] LeakPreventionAction evaluateAction() const {
+            return LeakEvaluator::getAction(criteria, state);
+        }
+
+        /**
+         * Criterion state is stored in the native number format, so checkpoints of a fixed-point
+         * build only restore the configuration in a floating-point build and vice versa.
+         */
+#ifdef LEAK_LOGIC_FIXED_POINT
+        static constexpr uint8_t CHECKPOINT_FLAGS = 0x01;
+#else
+        static constexpr uint8_t CHECKPOINT_FLAGS = 0x00;
+#endif
+
+        CriteriaSet criteria;
+        LeakLogicState state;
+
+        LeakPreventionAction cachedAction = LeakPreventionAction(ActionType::NO_ACTION);
+        uint32_t actionGeneration = 0;
+
+        std::atomic<CriteriaSet*> publishedCriteria { nullptr };
+        std::atomic<CriteriaSet*> retiredCriteria { nullptr };
     };
 
 
@@ -0,0 +1,157 @@
+#ifndef LEAK_LOGIC_T_HPP
+#define LEAK_LOGIC_T_HPP
+
+#include "leakguard/leak_logic.hpp"
+
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace lg {
+
+    /**
+     * @brief Leak detection logic over a closed set of criterion types.
+     *
+     * Unlike LeakLogic, criteria are stored by value in a variant and dispatched statically, so
+     * update() and getAction() compile down to direct (inlinable) calls with no virtual dispatch
+     * or heap allocation. Criteria are evaluated in insertion order, as in LeakLogic.
+     *
+     * @tparam Criteria Final criterion classes this logic can hold.
+     */
+    template <typename... Criteria>
+    class LeakLogicT {
+        static_assert(sizeof...(Criteria) > 0, "At least one criterion type is required");
+        static_assert((std::is_base_of_v<LeakDetectionCriterion, Criteria> && ...),
+            "Criteria must derive from LeakDetectionCriterion");
+        static_assert((std::is_final_v<Criteria> && ...),
+            "Criteria must be final, otherwise calls cannot be devirtualized");
+
+    public:
+        using CriterionVariant = std::variant<std::monostate, Criteria...>;
+
+        /**
+         * @brief Update the leak logic with the current sensor state and time elapsed since the last update.
+         *
+         * @param sensorState The current sensor state.
+         * @param elapsedTime Time in seconds since the last update.
+         */
+        void update(const SensorState& sensorState, const time_t elapsedTime) {
+            LeakEvaluator::update(*this, state, sensorState, elapsedTime);
+        }
+
+        /**
+         * @brief Fast-forward the leak logic over a span of constant sensor input.
+         *
+         * @param sensorState The sensor state throughout the span.
+         * @param duration Length of the span, in seconds.
+         */
+        void advance(const SensorState& sensorState, const time_t duration) {
+            LeakEvaluator::advance(*this, state, sensorState, duration);
+        }
+
+        /**
+         * @brief Get the action determined by specified leak detection criteria.
+         */
+        [[nodiscard]] LeakPreventionAction getAction() const {
+            return LeakEvaluator::getAction(*this, state);
+        }
+
+        /**
+         * @brief Time in seconds until any criterion could take action, if the sensors keep their last state.
+         */
+        [[nodiscard]] time_t timeUntilNextPossibleAction() const {
+            return LeakEvaluator::timeUntilNextPossibleAction(*this, state);
+        }
+
+        /**
+         * @brief Call f with each concrete criterion in order, see LeakEvaluator.
+         */
+        template <typename F>
+        void forEach(F&& f) {
+            for (auto& criterion : criteria) {
+                dispatch(criterion, f);
+            }
+        }
+
+        template <typename F>
+        void forEach(F&& f) const {
+            for (const auto& criterion : criteria) {
+                dispatch(criterion, f);
+            }
+        }
+
+        /**
+         * @brief Construct a criterion for leak detection in place.
+         *
+         * @param args Arguments forwarded to the constructor of T.
+         * @return Whether the criterion was added successfully.
+         */
+        template <typename T, typename... Args>
+        bool emplaceCriterion(Args&&... args) {
+            static_assert((std::is_same_v<T, Criteria> || ...), "T is not one of the criteria of this logic");
+
+            if (!criteria.Append(CriterionVariant()))
+                return false;
+
+            criteria[criteria.GetSize() - 1].template emplace<T>(std::forward<Args>(args)...);
+            return true;
+        }
+
+        /**
+         * @brief Gets an iterator for the leak detection criteria list.
+         */
+        typename StaticVector<CriterionVariant, LEAK_LOGIC_MAX_CRITERIA>::Iterator getCriteria() {
+            return criteria.begin();
+        }
+
+        /**
+         * @brief Removes a criterion for leak detection from the list.
+         *
+         * @param index Index of the criterion to remove.
+         * @return Whether the criterion was removed successfully.
+         */
+        bool removeCriterion(const uint8_t index) {
+            return criteria.RemoveIndex(index);
+        }
+
+        void clearCriteria() {
+            criteria.Clear();
+        }
+
+        [[nodiscard]] StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH> serialize() const {
+            StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH> serialized;
+
+            for (const auto& criterion : criteria) {
+                dispatch(criterion, [&](const auto& concrete) {
+                    serialized += concrete.serialize();
+                });
+                serialized += StaticString<1>("|");
+            }
+
+            return serialized;
+        }
+
+    private:
+        /**
+         * @brief Call f with the concrete criterion held by the variant, if any.
+         *
+         * Expands to a chain of index comparisons rather than std::visit's table of function
+         * pointers, which keeps every call site visible to the inliner.
+         */
+        template <typename Variant, typename F>
+        static void dispatch(Variant& criterion, F&& f) {
+            dispatchImpl(criterion, f, std::index_sequence_for<Criteria...>());
+        }
+
+        template <typename Variant, typename F, size_t... I>
+        static void dispatchImpl(Variant& criterion, F& f, std::index_sequence<I...>) {
+            const size_t index = criterion.index();
+            static_cast<void>(((index == I + 1 ? (f(*std::get_if<I + 1>(&criterion)), true) : false) || ...));
+        }
+
+        StaticVector<CriterionVariant, LEAK_LOGIC_MAX_CRITERIA> criteria;
+        LeakLogicState state;
+    };
+
+}
+#endif //LEAK_LOGIC_T_HPP
@@ -0,0 +1,110 @@
+#ifndef SAMPLE_RING_HPP
+#define SAMPLE_RING_HPP
+
+#include "leakguard/leak_logic.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#define LEAK_LOGIC_SAMPLE_RING_CAPACITY 64
+
+namespace lg {
+
+    /**
+     * @brief Fixed-capacity single-producer/single-consumer queue of sensor samples.
+     *
+     * Lets an interrupt handler hand samples to the task running LeakLogic without disabling interrupts:
+     * push() is wait-free and only uses atomic loads and stores, so it is safe on cores without atomic
+     * read-modify-write instructions. The consumer applies everything pending with LeakLogic::drain().
+     *
+     * There must be a single producer context. Interrupts that can preempt each other need a ring each.
+     */
+    template <size_t Capacity = LEAK_LOGIC_SAMPLE_RING_CAPACITY>
+    class SampleRing {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+        static_assert(Capacity <= UINT32_MAX / 2, "Capacity must fit the 32-bit indices");
+        static_assert(std::atomic<uint32_t>::is_always_lock_free, "SampleRing needs lock-free 32-bit atomics");
+
+    public:
+        /**
+         * @brief Queue a sample. Producer side only.
+         *
+         * @return Whether the sample was queued. If the ring is full, the sample is dropped and counted.
+         */
+        bool push(const SensorSample& sample) {
+            const uint32_t currentTail = tail.load(std::memory_order_relaxed);
+            if (currentTail - head.load(std::memory_order_acquire) == Capacity) {
+                dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            samples[currentTail & (Capacity - 1)] = sample;
+            tail.store(currentTail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Take the oldest sample. Consumer side only.
+         *
+         * @return Whether there was a sample.
+         */
+        bool pop(SensorSample& sample) {
+            const uint32_t currentHead = head.load(std::memory_order_relaxed);
+            if (currentHead == tail.load(std::memory_order_acquire))
+                return false;
+
+            sample = samples[currentHead & (Capacity - 1)];
+            head.store(currentHead + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Call f for every sample queued so far, oldest first. Consumer side only.
+         *
+         * Samples pushed meanwhile are left for the next call, so this always terminates.
+         *
+         * @return Number of samples consumed.
+         */
+        template <typename F>
+        size_t consume(F&& f) {
+            const uint32_t currentHead = head.load(std::memory_order_relaxed);
+            const uint32_t currentTail = tail.load(std::memory_order_acquire);
+
+            for (uint32_t i = currentHead; i != currentTail; i++) {
+                f(static_cast<const SensorSample&>(samples[i & (Capacity - 1)]));
+
+                // Free the slot right away, so the producer never waits for the whole batch
+                head.store(i + 1, std::memory_order_release);
+            }
+            return currentTail - currentHead;
+        }
+
+        /**
+         * @brief Number of queued samples. Exact only when called from the consumer with the producer idle.
+         */
+        [[nodiscard]] size_t getSize() const {
+            return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] static constexpr size_t getCapacity() { return Capacity; }
+
+        /**
+         * @brief Number of samples dropped because the ring was full.
+         */
+        [[nodiscard]] uint32_t getDroppedCount() const {
+            return dropped.load(std::memory_order_relaxed);
+        }
+
+    private:
+        SensorSample samples[Capacity];
+
+        // Indices run freely and wrap at 2^32; the slot is the index modulo Capacity.
+        // Separate cache lines keep the producer and the consumer from invalidating each other on hosts.
+        alignas(64) std::atomic<uint32_t> head { 0 };
+        alignas(64) std::atomic<uint32_t> tail { 0 };
+        std::atomic<uint32_t> dropped { 0 };
+    };
+
+}
+#endif //SAMPLE_RING_HPP
@@ -0,0 +1,96 @@
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace lg {
+
+    /**
+     * @brief Publishes a value from one writer thread to any number of reader threads without locking.
+     *
+     * The writer never waits for readers. A reader retries only if the writer stored a new value while
+     * it was copying, so readers never see a torn value and never stall the writer.
+     *
+     * The value is kept as relaxed atomic words rather than a plain T, so concurrent copies are not a
+     * data race.
+     */
+    template <typename T>
+    class SeqLock {
+        static_assert(std::is_trivially_copyable_v<T>, "SeqLock values are copied bytewise");
+        static_assert(std::is_default_constructible_v<T>, "SeqLock values must be default constructible");
+
+    public:
+        SeqLock() {
+            store(T {});
+        }
+
+        /**
+         * @brief Publish a new value. Writer thread only.
+         */
+        void store(const T& value) {
+            uint64_t buffer[WORD_COUNT] {};
+            std::memcpy(buffer, &value, sizeof(T));
+
+            // Odd sequence while the words are being written
+            const uint32_t current = sequence.load(std::memory_order_relaxed);
+            sequence.store(current + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            for (size_t i = 0; i < WORD_COUNT; i++)
+                words[i].store(buffer[i], std::memory_order_relaxed);
+
+            sequence.store(current + 2, std::memory_order_release);
+        }
+
+        /**
+         * @brief Copy the value, unless the writer is publishing a new one at the same time.
+         *
+         * @return Whether the copy is consistent. If not, value is left untouched.
+         */
+        bool tryLoad(T& value) const {
+            const uint32_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1)
+                return false;
+
+            uint64_t buffer[WORD_COUNT];
+            for (size_t i = 0; i < WORD_COUNT; i++)
+                buffer[i] = words[i].load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) != before)
+                return false;
+
+            std::memcpy(&value, buffer, sizeof(T));
+            return true;
+        }
+
+        /**
+         * @brief Copy the latest consistent value, retrying while the writer is publishing.
+         */
+        [[nodiscard]] T load() const {
+            T value;
+            while (!tryLoad(value)) {}
+            return value;
+        }
+
+        /**
+         * @brief Incremented by 2 with every store(), so readers can tell whether anything was published
+         * since they last looked.
+         */
+        [[nodiscard]] uint32_t getSequence() const {
+            return sequence.load(std::memory_order_acquire);
+        }
+
+    private:
+        static constexpr size_t WORD_COUNT = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+        std::atomic<uint32_t> sequence { 0 };
+        std::atomic<uint64_t> words[WORD_COUNT] {};
+    };
+
+}
+#endif //SEQLOCK_HPP
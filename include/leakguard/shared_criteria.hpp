@@ -0,0 +1,368 @@
+#ifndef SHARED_CRITERIA_HPP
+#define SHARED_CRITERIA_HPP
+
+#include "leakguard/leak_logic.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <unordered_map>
+#include <variant>
+
+namespace lg {
+
+    /**
+     * @brief Immutable criteria configuration, shared by every SharedLeakLogic configured the same.
+     *
+     * Criteria are split into their parameters, kept here once, and their runtime state, kept by the
+     * caller as a plain block of getStateSize() bytes per instance. Many households running the same
+     * rules thus only pay for their state, not for a copy of the parameters, a vtable pointer and a slot
+     * per criterion as with LeakLogic.
+     */
+    class SharedCriteria {
+    public:
+        using Config = std::variant<
+            TimeBasedFlowRateCriterion::Config,
+            VolumeWindowCriterion::Config,
+            ProbeLeakDetectionCriterion::Config>;
+
+        /**
+         * @brief Alignment required of state blocks. getStateSize() is a multiple of it, so blocks can be
+         * packed into an array.
+         */
+        static constexpr size_t STATE_ALIGNMENT = alignof(std::max_align_t);
+
+        /**
+         * @brief Runtime state shared by all criteria, at the start of every state block.
+         */
+        using Header = LeakLogicState;
+
+        /**
+         * @brief Build criteria from a binary configuration.
+         *
+         * @return The criteria, or nullptr if the configuration is invalid or contains unknown criteria.
+         */
+        static std::shared_ptr<const SharedCriteria> fromBinary(const BinaryConfigView& config) {
+            if (!config.isValid())
+                return nullptr;
+
+            auto criteria = std::make_shared<SharedCriteria>();
+
+            size_t stateSize = sizeof(Header);
+            for (const auto record : config) {
+                Config entry;
+                if (!parseRecord(record, entry))
+                    return nullptr;
+
+                stateSize = std::visit([&](const auto& concrete) {
+                    using Criterion = typename std::decay_t<decltype(concrete)>::Criterion;
+                    return alignUp(stateSize, alignof(typename Criterion::State));
+                }, entry);
+
+                if (!criteria->entries.Append(Entry { entry, static_cast<uint16_t>(stateSize) }))
+                    return nullptr;
+                stateSize += std::visit([](const auto& concrete) {
+                    return sizeof(typename std::decay_t<decltype(concrete)>::Criterion::State);
+                }, entry);
+            }
+
+            criteria->stateSize = alignUp(stateSize, STATE_ALIGNMENT);
+            criteria->configHash = config.getCrc();
+            return criteria;
+        }
+
+        [[nodiscard]] size_t getCount() const { return entries.GetSize(); }
+        [[nodiscard]] const Config& getConfig(const size_t index) const { return entries[index].config; }
+
+        /**
+         * @brief Offset of the state of a criterion within the state block.
+         */
+        [[nodiscard]] size_t getStateOffset(const size_t index) const { return entries[index].stateOffset; }
+
+        /**
+         * @brief Bytes of runtime state per instance, including the Header.
+         */
+        [[nodiscard]] size_t getStateSize() const { return stateSize; }
+
+        /**
+         * @brief Hash of the configuration, the same as LeakLogic::getConfigHash() with these criteria.
+         */
+        [[nodiscard]] uint32_t getConfigHash() const { return configHash; }
+
+    private:
+        struct Entry {
+            Config config;
+            uint16_t stateOffset;
+        };
+
+        static bool parseRecord(const BinaryConfigView::Record& record, Config& entry) {
+            switch (record.type) {
+                case 'T': {
+                    FlowRate rateThreshold;
+                    time_t minDuration;
+                    if (!TimeBasedFlowRateCriterion::parseBinary(record, rateThreshold, minDuration))
+                        return false;
+                    entry = TimeBasedFlowRateCriterion::makeConfig(rateThreshold, minDuration);
+                    return true;
+                }
+                case 'V': {
+                    Volume maxVolume;
+                    time_t window;
+                    time_t bucketWidth;
+                    if (!VolumeWindowCriterion::parseBinary(record, maxVolume, window, bucketWidth))
+                        return false;
+                    entry = VolumeWindowCriterion::makeConfig(maxVolume, window, bucketWidth);
+                    return true;
+                }
+                case 'P':
+                    entry = ProbeLeakDetectionCriterion::Config {};
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        static constexpr size_t alignUp(const size_t value, const size_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        StaticVector<Entry, LEAK_LOGIC_MAX_CRITERIA> entries;
+        size_t stateSize = 0;
+        uint32_t configHash = 0;
+    };
+
+    /**
+     * @brief Interns SharedCriteria, so that all households configured the same share a single instance.
+     *
+     * Not thread-safe. Intern the configurations before handing the criteria to worker threads.
+     */
+    class SharedCriteriaPool {
+    public:
+        /**
+         * @brief Get the shared criteria for a binary configuration, building them on first use.
+         *
+         * Unknown criteria are skipped, as by LeakLogic::loadFromBinary().
+         *
+         * @return The criteria, or nullptr if the configuration is invalid.
+         */
+        std::shared_ptr<const SharedCriteria> intern(const BinaryConfigView& config) {
+            CriteriaSet parsed;
+            if (!parsed.loadFromBinary(config))
+                return nullptr;
+
+            return intern(parsed);
+        }
+
+        /**
+         * @brief Get the shared criteria for a text configuration, building them on first use.
+         *
+         * @return The criteria, or nullptr if the configuration could not be parsed.
+         */
+        std::shared_ptr<const SharedCriteria> intern(const StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH>& configuration) {
+            CriteriaSet parsed;
+            if (!parsed.loadFromString(configuration))
+                return nullptr;
+
+            return intern(parsed);
+        }
+
+        /**
+         * @brief Number of distinct configurations interned.
+         */
+        [[nodiscard]] size_t getSize() const { return criteria.size(); }
+
+    private:
+        struct Interned {
+            std::shared_ptr<const SharedCriteria> criteria;
+
+            /**
+             * Binary configuration, to tell configurations with colliding hashes apart.
+             */
+            uint8_t config[LEAK_LOGIC_MAX_SERIALIZE_LENGTH];
+            size_t configLength;
+        };
+
+        std::shared_ptr<const SharedCriteria> intern(const CriteriaSet& parsed) {
+            // Re-serialize, so configurations that only differ in skipped records are the same
+            Interned candidate;
+            candidate.configLength = parsed.serializeBinary(candidate.config, sizeof(candidate.config));
+            if (candidate.configLength == 0)
+                return nullptr;
+
+            const BinaryConfigView config(candidate.config, candidate.configLength);
+            const auto [first, last] = criteria.equal_range(config.getCrc());
+            for (auto it = first; it != last; ++it) {
+                const Interned& existing = it->second;
+                if (existing.configLength == candidate.configLength
+                    && std::memcmp(existing.config, candidate.config, candidate.configLength) == 0)
+                    return existing.criteria;
+            }
+
+            candidate.criteria = SharedCriteria::fromBinary(config);
+            if (!candidate.criteria)
+                return nullptr;
+
+            return criteria.emplace(config.getCrc(), candidate)->second.criteria;
+        }
+
+        std::unordered_multimap<uint32_t, Interned> criteria;
+    };
+
+    /**
+     * @brief Leak detection logic over SharedCriteria, keeping its runtime state in a block owned by the caller.
+     *
+     * Holds nothing but a reference to the criteria and a pointer to the block, so it can be constructed
+     * on the fly for each household, e.g. over state blocks packed into a single array. Criteria are
+     * evaluated in order, as in LeakLogic.
+     */
+    class SharedLeakLogic {
+    public:
+        /**
+         * @param criteria The shared criteria. Must outlive the logic.
+         * @param state Block of criteria.getStateSize() bytes aligned to SharedCriteria::STATE_ALIGNMENT,
+         *              initialized with reset() before first use.
+         */
+        SharedLeakLogic(const SharedCriteria& criteria, void* state)
+            : criteria(criteria), state(static_cast<unsigned char*>(state)) {}
+
+        /**
+         * @brief Initialize the state block, as for a newly constructed LeakLogic.
+         */
+        void reset() {
+            new (state) SharedCriteria::Header {};
+            for (size_t i = 0; i < criteria.getCount(); i++) {
+                std::visit([&](const auto& config) {
+                    using Criterion = typename std::decay_t<decltype(config)>::Criterion;
+                    new (state + criteria.getStateOffset(i)) typename Criterion::State {};
+                }, criteria.getConfig(i));
+            }
+        }
+
+        /**
+         * @brief Update the leak logic with the current sensor state and time elapsed since the last update.
+         */
+        void update(const SensorState& sensorState, const time_t elapsedTime) {
+            LeakEvaluator::update(*this, header(), sensorState, elapsedTime);
+        }
+
+        /**
+         * @brief Fast-forward the leak logic over a span of constant sensor input, see LeakLogic::advance().
+         */
+        void advance(const SensorState& sensorState, const time_t duration) {
+            LeakEvaluator::advance(*this, header(), sensorState, duration);
+        }
+
+        /**
+         * @brief Inform the leak logic that a single probe changed state, see LeakLogic::onProbeChanged().
+         */
+        void onProbeChanged(const uint8_t probeId, const bool wet) {
+            LeakEvaluator::onProbeChanged(*this, header(), probeId, wet);
+        }
+
+        /**
+         * @brief Update the leak logic with a new flow rate sample, keeping the last known probe states.
+         */
+        void onFlowSample(const FlowRate flowRate, const time_t elapsedTime) {
+            LeakEvaluator::onFlowSample(*this, header(), flowRate, elapsedTime);
+        }
+
+        /**
+         * @brief Set the calibration constant of a pulse-counting flow meter, see LeakLogic::setPulseCalibration().
+         *
+         * Kept in the state block, so households sharing criteria can have different flow meters.
+         */
+        void setPulseCalibration(const uint32_t pulsesPerLiter) {
+            header().calibration = PulseCalibration(pulsesPerLiter);
+        }
+
+        [[nodiscard]] uint32_t getPulseCalibration() const { return header().calibration.pulsesPerLiter; }
+
+        /**
+         * @brief Update the leak logic with a raw flow meter pulse count, see LeakLogic::onPulseSample().
+         */
+        void onPulseSample(const uint32_t pulses, const time_t elapsedTime) {
+            LeakEvaluator::onPulseSample(*this, header(), pulses, elapsedTime);
+        }
+
+        /**
+         * @brief Get the action determined by the criteria, as LeakLogic::getAction() would.
+         */
+        [[nodiscard]] LeakPreventionAction getAction() const {
+            return LeakEvaluator::getAction(*this, header());
+        }
+
+        /**
+         * @brief Seconds until the earliest criterion takes action, see LeakLogic::timeUntilNextPossibleAction().
+         */
+        [[nodiscard]] time_t timeUntilNextPossibleAction() const {
+            return LeakEvaluator::timeUntilNextPossibleAction(*this, header());
+        }
+
+        [[nodiscard]] const SensorState& getSensorState() const { return header().sensorState; }
+
+        /**
+         * @brief Call f with each criterion in order, bound to its state in the block, see LeakEvaluator.
+         */
+        template <typename F>
+        void forEach(F&& f) const {
+            for (size_t i = 0; i < criteria.getCount(); i++) {
+                std::visit([&](const auto& config) {
+                    using Criterion = typename std::decay_t<decltype(config)>::Criterion;
+                    f(BoundCriterion<Criterion> { config, stateOf<Criterion>(i) });
+                }, criteria.getConfig(i));
+            }
+        }
+
+    private:
+        /**
+         * @brief A criterion's shared configuration together with its state, with the members of
+         * LeakDetectionCriterion that LeakEvaluator calls.
+         */
+        template <typename Criterion>
+        struct BoundCriterion {
+            const typename Criterion::Config& config;
+            typename Criterion::State& state;
+
+            void update(const SensorState& sensorState, const time_t elapsedTime) const {
+                Criterion::advance(config, state, sensorState, elapsedTime);
+            }
+
+            void advance(const SensorState& sensorState, const time_t duration) const {
+                Criterion::advance(config, state, sensorState, duration);
+            }
+
+            bool updatePulses(const PulseCalibration& calibration, const uint32_t pulses, const time_t elapsedTime) const {
+                return Criterion::updatePulses(config, state, calibration, pulses, elapsedTime);
+            }
+
+            void onProbeChanged(const ProbeMask& probeStates, const uint8_t probeId, const bool wet) const {
+                if constexpr (std::is_same_v<Criterion, ProbeLeakDetectionCriterion>)
+                    Criterion::onProbeChanged(state, probeStates, probeId, wet);
+            }
+
+            [[nodiscard]] std::optional<LeakPreventionAction> getAction() const {
+                return Criterion::getAction(config, state);
+            }
+
+            [[nodiscard]] time_t timeUntilAction() const {
+                return Criterion::timeUntilAction(config, state);
+            }
+        };
+
+        SharedCriteria::Header& header() const {
+            return *std::launder(reinterpret_cast<SharedCriteria::Header*>(state));
+        }
+
+        template <typename Criterion>
+        typename Criterion::State& stateOf(const size_t index) const {
+            return *std::launder(reinterpret_cast<typename Criterion::State*>(state + criteria.getStateOffset(index)));
+        }
+
+        const SharedCriteria& criteria;
+        unsigned char* state;
+    };
+
+}
+#endif //SHARED_CRITERIA_HPP
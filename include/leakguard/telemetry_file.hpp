@@ -0,0 +1,415 @@
+#ifndef TELEMETRY_FILE_HPP
+#define TELEMETRY_FILE_HPP
+
+#include "leakguard/fleet_replay.hpp"
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <span>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LEAK_LOGIC_TELEMETRY_VERSION 1
+
+namespace lg {
+
+    static_assert(std::endian::native == std::endian::little, "Telemetry files are read in place as little-endian");
+
+    /**
+     * @brief Columnar telemetry file layout.
+     *
+     * All fields are little-endian, blocks are 8-byte aligned.
+     *  - header: magic "LGTF", version (u32), household count (u32), reserved (u32),
+     *  - directory: one TelemetryDirectoryEntry per household,
+     *  - per household block: quantized flow rates (u16 centiliters per minute, one per sample),
+     *    probe events (TelemetryProbeEvent, sparse), timestamp deltas (unsigned LEB128, the first
+     *    one relative to the base timestamp).
+     */
+    struct TelemetryFileHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t householdCount;
+        uint32_t reserved;
+    };
+
+    struct TelemetryDirectoryEntry {
+        uint64_t offset;
+        int64_t baseTimestamp;
+        uint32_t sampleCount;
+        uint32_t probeEventCount;
+        uint32_t timestampBytes;
+        uint32_t reserved;
+    };
+
+    struct TelemetryProbeEvent {
+        uint32_t sampleIndex;
+        uint8_t probeId;
+        uint8_t wet;
+        uint16_t reserved;
+    };
+
+    /**
+     * @brief Read-only view of the telemetry of a single household, decoded while iterating.
+     */
+    class HouseholdTelemetry {
+    public:
+        HouseholdTelemetry(const uint8_t* block, const TelemetryDirectoryEntry& entry)
+            : block(block), entry(entry) {}
+
+        [[nodiscard]] size_t getSampleCount() const { return entry.sampleCount; }
+        [[nodiscard]] size_t getProbeEventCount() const { return entry.probeEventCount; }
+
+        /**
+         * @brief Call f with every sample, in order, without allocating.
+         */
+        template <typename F>
+        void forEachSample(F&& f) const {
+            const uint8_t* flowRates = block;
+            const uint8_t* probeEvents = flowRates + flowRatesSize(entry.sampleCount);
+            const uint8_t* timestamps = probeEvents + probeEventsSize(entry.probeEventCount);
+            const uint8_t* timestampsEnd = timestamps + entry.timestampBytes;
+
+            time_t timestamp = entry.baseTimestamp;
+            size_t nextEvent = 0;
+
+            for (uint32_t i = 0; i < entry.sampleCount; i++) {
+                uint64_t delta = 0;
+                for (unsigned shift = 0; timestamps < timestampsEnd && shift < 64; shift += 7) {
+                    const uint8_t byte = *timestamps++;
+                    delta |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                    if ((byte & 0x80) == 0)
+                        break;
+                }
+                timestamp += static_cast<time_t>(delta);
+
+                uint16_t quantizedFlowRate;
+                std::memcpy(&quantizedFlowRate, flowRates + i * sizeof(uint16_t), sizeof(uint16_t));
+                ReplaySample sample { timestamp, static_cast<float>(quantizedFlowRate) / 100.0f };
+
+                // Several probe events on one sample are delivered as repeated samples with no elapsed time
+                TelemetryProbeEvent event;
+                while (nextEvent < entry.probeEventCount) {
+                    std::memcpy(&event, probeEvents + nextEvent * sizeof(event), sizeof(event));
+                    if (event.sampleIndex != i)
+                        break;
+
+                    if (sample.probeId >= 0)
+                        f(static_cast<const ReplaySample&>(sample));
+                    sample.probeId = event.probeId;
+                    sample.probeWet = event.wet != 0;
+                    nextEvent++;
+                }
+
+                f(static_cast<const ReplaySample&>(sample));
+            }
+        }
+
+        /**
+         * @brief Replay this household through a leak logic.
+         */
+        void replay(HouseholdReplayer& replayer) const {
+            forEachSample([&replayer](const ReplaySample& sample) { replayer.feed(sample); });
+        }
+
+        static constexpr size_t flowRatesSize(const size_t sampleCount) {
+            return align(sampleCount * sizeof(uint16_t));
+        }
+
+        static constexpr size_t probeEventsSize(const size_t probeEventCount) {
+            return probeEventCount * sizeof(TelemetryProbeEvent);
+        }
+
+        static constexpr size_t align(const size_t size) { return (size + 7) & ~size_t { 7 }; }
+
+    private:
+        const uint8_t* block;
+        TelemetryDirectoryEntry entry;
+    };
+
+    /**
+     * @brief Read-only view of a telemetry file in memory.
+     */
+    class TelemetryView {
+    public:
+        TelemetryView() = default;
+
+        TelemetryView(const uint8_t* data, const size_t size)
+            : data(data), size(size) {}
+
+        /**
+         * @brief Check the header and that every household block lies within the buffer.
+         */
+        [[nodiscard]] bool isValid() const {
+            if (data == nullptr || size < sizeof(TelemetryFileHeader))
+                return false;
+
+            TelemetryFileHeader header;
+            std::memcpy(&header, data, sizeof(header));
+            if (std::memcmp(header.magic, "LGTF", 4) != 0 || header.version != LEAK_LOGIC_TELEMETRY_VERSION)
+                return false;
+            if (sizeof(TelemetryFileHeader) + uint64_t { header.householdCount } * sizeof(TelemetryDirectoryEntry) > size)
+                return false;
+
+            for (size_t i = 0; i < header.householdCount; i++) {
+                const TelemetryDirectoryEntry entry = getEntry(i);
+                const uint64_t blockSize = HouseholdTelemetry::flowRatesSize(entry.sampleCount)
+                    + HouseholdTelemetry::probeEventsSize(entry.probeEventCount) + entry.timestampBytes;
+                if (entry.offset > size || blockSize > size - entry.offset)
+                    return false;
+            }
+            return true;
+        }
+
+        [[nodiscard]] size_t getHouseholdCount() const {
+            TelemetryFileHeader header;
+            std::memcpy(&header, data, sizeof(header));
+            return header.householdCount;
+        }
+
+        [[nodiscard]] HouseholdTelemetry getHousehold(const size_t household) const {
+            const TelemetryDirectoryEntry entry = getEntry(household);
+            return HouseholdTelemetry(data + entry.offset, entry);
+        }
+
+    private:
+        [[nodiscard]] TelemetryDirectoryEntry getEntry(const size_t household) const {
+            TelemetryDirectoryEntry entry;
+            std::memcpy(&entry, data + sizeof(TelemetryFileHeader) + household * sizeof(entry), sizeof(entry));
+            return entry;
+        }
+
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    /**
+     * @brief Memory-mapped telemetry file.
+     */
+    class TelemetryFile {
+    public:
+        TelemetryFile() = default;
+
+        TelemetryFile(const TelemetryFile&) = delete;
+        TelemetryFile& operator=(const TelemetryFile&) = delete;
+
+        TelemetryFile(TelemetryFile&& other) noexcept
+            : mapping(other.mapping), size(other.size) {
+            other.mapping = nullptr;
+            other.size = 0;
+        }
+
+        TelemetryFile& operator=(TelemetryFile&& other) noexcept {
+            if (this != &other) {
+                close();
+                mapping = other.mapping;
+                size = other.size;
+                other.mapping = nullptr;
+                other.size = 0;
+            }
+            return *this;
+        }
+
+        ~TelemetryFile() { close(); }
+
+        /**
+         * @brief Map a telemetry file into memory.
+         *
+         * @return Whether the file could be mapped and is a valid telemetry file.
+         */
+        bool open(const char* path) {
+            close();
+
+            const int fd = ::open(path, O_RDONLY);
+            if (fd < 0)
+                return false;
+
+            struct stat status {};
+            if (fstat(fd, &status) != 0 || status.st_size == 0) {
+                ::close(fd);
+                return false;
+            }
+
+            void* mapped = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (mapped == MAP_FAILED)
+                return false;
+
+            madvise(mapped, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+            mapping = mapped;
+            size = static_cast<size_t>(status.st_size);
+
+            if (!getView().isValid()) {
+                close();
+                return false;
+            }
+            return true;
+        }
+
+        void close() {
+            if (mapping != nullptr)
+                munmap(mapping, size);
+            mapping = nullptr;
+            size = 0;
+        }
+
+        [[nodiscard]] TelemetryView getView() const {
+            return TelemetryView(static_cast<const uint8_t*>(mapping), size);
+        }
+
+        [[nodiscard]] size_t getHouseholdCount() const { return getView().getHouseholdCount(); }
+        [[nodiscard]] HouseholdTelemetry getHousehold(const size_t household) const { return getView().getHousehold(household); }
+
+        /**
+         * @brief Register every household of the file with a fleet replay, all using the same configuration.
+         *
+         * The file must stay open until the replay has run.
+         *
+         * @return Whether the configuration could be parsed.
+         */
+        bool addTo(FleetReplay& fleet, const StaticString<LEAK_LOGIC_MAX_SERIALIZE_LENGTH>& configuration) const {
+            for (size_t i = 0; i < getHouseholdCount(); i++) {
+                const HouseholdTelemetry household = getHousehold(i);
+                const auto source = [household](HouseholdReplayer& replayer) { household.replay(replayer); };
+                if (fleet.addHousehold(configuration, source, household.getSampleCount()) < 0)
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+        void* mapping = nullptr;
+        size_t size = 0;
+    };
+
+    /**
+     * @brief Builds a telemetry file in memory.
+     */
+    class TelemetryWriter {
+    public:
+        /**
+         * @brief Append the telemetry of a household.
+         *
+         * Flow rates are quantized to centiliters per minute (0 to 655.35 L/min).
+         *
+         * @return Whether the samples were ordered by time.
+         */
+        bool addHousehold(const std::span<const ReplaySample> samples) {
+            HouseholdData household;
+            household.baseTimestamp = samples.empty() ? 0 : samples.front().timestamp;
+
+            time_t lastTimestamp = household.baseTimestamp;
+            for (size_t i = 0; i < samples.size(); i++) {
+                const ReplaySample& sample = samples[i];
+                if (sample.timestamp < lastTimestamp)
+                    return false;
+
+                uint64_t delta = static_cast<uint64_t>(sample.timestamp - lastTimestamp);
+                lastTimestamp = sample.timestamp;
+                do {
+                    const uint8_t byte = delta & 0x7F;
+                    delta >>= 7;
+                    household.timestamps.push_back(delta != 0 ? byte | 0x80 : byte);
+                } while (delta != 0);
+
+                const float centiliters = sample.flowRate * 100.0f + 0.5f;
+                household.flowRates.push_back(
+                    centiliters <= 0.0f ? 0 : centiliters >= 65535.0f ? 65535 : static_cast<uint16_t>(centiliters));
+
+                if (sample.probeId >= 0) {
+                    household.probeEvents.push_back(TelemetryProbeEvent {
+                        static_cast<uint32_t>(i), static_cast<uint8_t>(sample.probeId), sample.probeWet, 0 });
+                }
+            }
+
+            households.push_back(std::move(household));
+            return true;
+        }
+
+        /**
+         * @brief Encode the file.
+         */
+        [[nodiscard]] std::vector<uint8_t> build() const {
+            const size_t directorySize = HouseholdTelemetry::align(
+                sizeof(TelemetryFileHeader) + households.size() * sizeof(TelemetryDirectoryEntry));
+
+            std::vector<TelemetryDirectoryEntry> directory;
+            size_t offset = directorySize;
+            for (const auto& household : households) {
+                directory.push_back(TelemetryDirectoryEntry {
+                    offset, household.baseTimestamp,
+                    static_cast<uint32_t>(household.flowRates.size()),
+                    static_cast<uint32_t>(household.probeEvents.size()),
+                    static_cast<uint32_t>(household.timestamps.size()), 0 });
+                offset += blockSize(household);
+            }
+
+            std::vector<uint8_t> file(offset);
+            const TelemetryFileHeader header { { 'L', 'G', 'T', 'F' }, LEAK_LOGIC_TELEMETRY_VERSION,
+                static_cast<uint32_t>(households.size()), 0 };
+            const auto copy = [](uint8_t* destination, const void* source, const size_t length) {
+                if (length != 0)
+                    std::memcpy(destination, source, length);
+            };
+
+            copy(file.data(), &header, sizeof(header));
+            copy(file.data() + sizeof(header), directory.data(), directory.size() * sizeof(TelemetryDirectoryEntry));
+
+            for (size_t i = 0; i < households.size(); i++) {
+                const HouseholdData& household = households[i];
+                uint8_t* block = file.data() + directory[i].offset;
+                copy(block, household.flowRates.data(), household.flowRates.size() * sizeof(uint16_t));
+                block += HouseholdTelemetry::flowRatesSize(household.flowRates.size());
+                copy(block, household.probeEvents.data(), household.probeEvents.size() * sizeof(TelemetryProbeEvent));
+                block += HouseholdTelemetry::probeEventsSize(household.probeEvents.size());
+                copy(block, household.timestamps.data(), household.timestamps.size());
+            }
+
+            return file;
+        }
+
+        /**
+         * @brief Encode the file and write it to disk.
+         */
+        bool write(const char* path) const {
+            const std::vector<uint8_t> file = build();
+            const int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0)
+                return false;
+
+            size_t written = 0;
+            while (written < file.size()) {
+                const ssize_t result = ::write(fd, file.data() + written, file.size() - written);
+                if (result <= 0) {
+                    ::close(fd);
+                    return false;
+                }
+                written += static_cast<size_t>(result);
+            }
+            return ::close(fd) == 0;
+        }
+
+    private:
+        struct HouseholdData {
+            time_t baseTimestamp = 0;
+            std::vector<uint16_t> flowRates;
+            std::vector<TelemetryProbeEvent> probeEvents;
+            std::vector<uint8_t> timestamps;
+        };
+
+        static size_t blockSize(const HouseholdData& household) {
+            return HouseholdTelemetry::align(HouseholdTelemetry::flowRatesSize(household.flowRates.size())
+                + HouseholdTelemetry::probeEventsSize(household.probeEvents.size())
+                + household.timestamps.size());
+        }
+
+        std::vector<HouseholdData> households;
+    };
+
+}
+#endif //TELEMETRY_FILE_HPP
@@ -0,0 +1,100 @@
+#ifndef WORK_STEALING_POOL_HPP
+#define WORK_STEALING_POOL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace lg {
+
+    /**
+     * @brief Runs a fixed set of indexed tasks on worker threads with work stealing.
+     *
+     * Tasks are dealt to per-worker queues heaviest first. Each worker runs its own queue from the
+     * back and, once empty, steals from the front of the other queues, so a few very heavy tasks
+     * cannot leave the remaining cores idle. Intended for host-side processing.
+     */
+    class WorkStealingPool {
+    public:
+        /**
+         * @param threadCount Number of worker threads, all hardware threads if 0.
+         */
+        explicit WorkStealingPool(const size_t threadCount = 0)
+            : threadCount(threadCount != 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency())) {}
+
+        [[nodiscard]] size_t getThreadCount() const { return threadCount; }
+
+        /**
+         * @brief Run every task once and wait for all of them to finish.
+         *
+         * @param weights Relative cost of each task, used only for the initial distribution.
+         * @param task Called as task(taskIndex, workerIndex), concurrently from several threads.
+         */
+        template <typename Task>
+        void run(const std::vector<size_t>& weights, Task&& task) {
+            std::vector<size_t> order(weights.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [&](const size_t a, const size_t b) {
+                return weights[a] > weights[b];
+            });
+
+            std::vector<Queue> queues(threadCount);
+            for (size_t i = 0; i < order.size(); i++)
+                queues[i % threadCount].tasks.push_front(order[i]);
+
+            const auto worker = [&](const size_t workerIndex) {
+                size_t taskIndex;
+                while (popOwn(queues[workerIndex], taskIndex) || steal(queues, workerIndex, taskIndex))
+                    task(taskIndex, workerIndex);
+            };
+
+            std::vector<std::thread> threads;
+            threads.reserve(threadCount - 1);
+            for (size_t i = 1; i < threadCount; i++)
+                threads.emplace_back(worker, i);
+
+            worker(0);
+
+            for (auto& thread : threads)
+                thread.join();
+        }
+
+    private:
+        struct Queue {
+            std::mutex mutex;
+            std::deque<size_t> tasks;
+        };
+
+        static bool popOwn(Queue& queue, size_t& taskIndex) {
+            std::lock_guard lock(queue.mutex);
+            if (queue.tasks.empty())
+                return false;
+
+            taskIndex = queue.tasks.back();
+            queue.tasks.pop_back();
+            return true;
+        }
+
+        bool steal(std::vector<Queue>& queues, const size_t thief, size_t& taskIndex) const {
+            for (size_t offset = 1; offset < threadCount; offset++) {
+                Queue& victim = queues[(thief + offset) % threadCount];
+                std::lock_guard lock(victim.mutex);
+                if (victim.tasks.empty())
+                    continue;
+
+                taskIndex = victim.tasks.front();
+                victim.tasks.pop_front();
+                return true;
+            }
+            return false;
+        }
+
+        size_t threadCount;
+    };
+
+}
+#endif //WORK_STEALING_POOL_HPP
@@ -0,0 +1,7 @@
+#include "suites/fixed_point_tests.hpp"
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include "leakguard/fleet_replay.hpp"
+#include <gtest/gtest.h>
+
+static_assert(std::is_same_v<lg::FlowRate, int32_t>, "fixed-point tests must be built with LEAK_LOGIC_FIXED_POINT");
+
+TEST(FixedPointTests, ShouldDetectLeakWithIntegerFlowRates) {
+    lg::LeakLogic logic;
+
+    // Detect leak if flow rate reaches 2 L/min for at least 1 minute
+    logic.emplaceCriterion<lg::TimeBasedFlowRateCriterion>(200, 60);
+
+    logic.onFlowSample(199, 120);
+    ASSERT_EQ(logic.getAction().getActionType(), lg::ActionType::NO_ACTION);
+
+    logic.onFlowSample(200, 59);
+    ASSERT_EQ(logic.getAction().getActionType(), lg::ActionType::NO_ACTION);
+
+    logic.onFlowSample(200, 1);
+    ASSERT_EQ(logic.getAction().getActionReason(), lg::ActionReason::EXCEEDED_FLOW_RATE);
+}
+
+TEST(FixedPointTests, ShouldAccumulateExactVolume) {
+    lg::LeakLogic logic;
+
+    // At most 10 liters within 10 minutes
+    logic.emplaceCriterion<lg::VolumeWindowCriterion>(1000, 600, 60);
+
+    // 3 L/min for 3 minutes, one second at a time
+    for (int i = 0; i < 180; i++)
+        logic.onFlowSample(300, 1);
+    ASSERT_EQ(logic.getAction().getActionType(), lg::ActionType::NO_ACTION);
+
+    const auto& criterion = static_cast<const lg::VolumeWindowCriterion&>(**logic.getCriteria());
+    ASSERT_EQ(criterion.getVolume(), 900);
+
+    for (int i = 0; i < 20; i++)
+        logic.onFlowSample(300, 1);
+    ASSERT_EQ(criterion.getVolume(), 1000);
+    ASSERT_EQ(logic.getAction().getActionReason(), lg::ActionReason::EXCEEDED_VOLUME);
+}
+
+TEST(FixedPointTests, ShouldRoundTripConfigurationAndCheckpoint) {
+    lg::LeakLogic logic;
+    ASSERT_TRUE(logic.loadFromString("T,250,60,|V,2050,3600,300,|"));
+    ASSERT_STREQ(logic.serialize().ToCStr(), "T,250,60,|V,2050,3600,300,|");
+
+    uint8_t config[64];
+    const size_t configLength = logic.serializeBinary(config, sizeof(config));
+    lg::LeakLogic binary;
+    ASSERT_TRUE(binary.loadFromBinary(config, configLength));
+    ASSERT_STREQ(binary.serialize().ToCStr(), "T,250,60,|V,2050,3600,300,|");
+
+    logic.onFlowSample(333, 45);
+    uint8_t buffer[256];
+    const size_t length = logic.saveCheckpoint(buffer, sizeof(buffer));
+    ASSERT_GT(length, 0u);
+
+    lg::LeakLogic restored;
+    ASSERT_TRUE(restored.restoreCheckpoint(buffer, length));
+    ASSERT_EQ(restored.getSensorState().flowRate, 333);
+
+    auto criteria = restored.getCriteria();
+    ++criteria;
+    const auto& volume = static_cast<const lg::VolumeWindowCriterion&>(**criteria);
+    ASSERT_EQ(volume.getVolume(), 333 * 45 / 60);
+
+    restored.onFlowSample(333, 15);
+    ASSERT_EQ(restored.getAction().getActionReason(), lg::ActionReason::EXCEEDED_FLOW_RATE);
+}
+
+TEST(FixedPointTests, ShouldConvertReplayedFlowRates) {
+    ASSERT_EQ(lg::flowRateFromLitersPerMinute(2.5f), 250);
+    ASSERT_EQ(lg::flowRateFromLitersPerMinute(0.125f), 13);
+
+    std::vector<lg::ReplaySample> samples;
+    for (time_t t = 0; t <= 60; t += 10)
+        samples.push_back(lg::ReplaySample { t, 2.0f });
+
+    lg::FleetReplay fleet;
+    fleet.addHousehold("T,200,60,|", samples);
+    const auto events = fleet.run(1);
+    ASSERT_EQ(events.size(), 1u);
+    ASSERT_EQ(events[0].timestamp, 60);
+}
+
+TEST(FixedPointTests, ShouldCountPulsesWithoutLosingVolume) {
+    lg::LeakLogic logic;
+    logic.setPulseCalibration(450);
+    logic.loadFromString("T,200,60,|V,1000,600,60,|");
+
+    // 4 pulses per second never reach 2 L/min, and do not divide evenly into centiliters
+    for (int i = 0; i < 599; i++)
+        logic.onPulseSample(4, 1);
+    ASSERT_EQ(logic.getAction().getActionType(), lg::ActionType::NO_ACTION);
+
+    auto criteria = logic.getCriteria();
+    ++criteria;
+    const auto& volume = static_cast<const lg::VolumeWindowCriterion&>(**criteria);
+    ASSERT_EQ(volume.getVolume(), 599 * 4 * 100 / 450);
+
+    logic.onPulseSample(30, 2);
+    ASSERT_EQ(logic.getAction().getActionType(), lg::ActionType::NO_ACTION);
+    logic.onPulseSample(15, 1);
+    ASSERT_EQ(logic.getAction().getActionType(), lg::ActionType::NO_ACTION);
+}
+
+TEST(FixedPointTests, AdvanceShouldMatchSmallStepsExactly) {
+    lg::VolumeWindowCriterion stepped(50000, 7200, 300);
+    lg::VolumeWindowCriterion advanced(50000, 7200, 300);
+    lg::ProbeMask probeStates;
+
+    const std::pair<lg::FlowRate, time_t> spans[] = { { 250, 17 }, { 0, 20000 }, { 333, 3599 }, { 1, 1 }, { 600, 5000 } };
+    for (const auto& [flowRate, duration] : spans) {
+        for (time_t i = 0; i < duration; i++)
+            stepped.update(lg::SensorState(flowRate, probeStates), 1);
+        advanced.advance(lg::SensorState(flowRate, probeStates), duration);
+
+        ASSERT_EQ(stepped.getVolume(), advanced.getVolume());
+        ASSERT_EQ(stepped.timeUntilAction(), advanced.timeUntilAction());
+    }
+}
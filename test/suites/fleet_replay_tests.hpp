@@ -0,0 +1,53 @@
+#pragma once
+#include "leakguard/fleet_replay.hpp"
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+TEST(FleetReplayTests, ShouldRunEveryTaskOnce) {
+    lg::WorkStealingPool pool(4);
+    std::vector<size_t> weights(1000);
+    for (size_t i = 0; i < weights.size(); i++)
+        weights[i] = i % 7 == 0 ? 100 : 1;
+
+    std::vector<std::atomic<int>> runs(weights.size());
+    pool.run(weights, [&](const size_t task, size_t) { runs[task]++; });
+
+    for (const auto& count : runs)
+        ASSERT_EQ(count.load(), 1);
+}
+
+TEST(FleetReplayTests, ShouldReplayDeterministically) {
+    std::vector<std::vector<lg::ReplaySample>> telemetry(50);
+    for (size_t household = 0; household < telemetry.size(); household++) {
+        const size_t sampleCount = household % 10 == 0 ? 5000 : 50;
+        for (size_t i = 0; i < sampleCount; i++) {
+            const float flowRate = (i / (household + 3)) % 2 == 0 ? 3.0f : 0.0f;
+            telemetry[household].push_back(lg::ReplaySample { static_cast<time_t>(i * 10), flowRate });
+        }
+        telemetry[household][20].probeId = static_cast<int16_t>(household);
+        telemetry[household][20].probeWet = household % 3 == 0;
+    }
+
+    const auto replay = [&](const size_t threadCount) {
+        lg::FleetReplay fleet;
+        for (const auto& samples : telemetry)
+            fleet.addHousehold("T,200,60,|", samples);
+        return fleet.run(threadCount);
+    };
+
+    const auto expected = replay(1);
+    const auto actual = replay(8);
+    ASSERT_FALSE(expected.empty());
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQ(expected[i].household, actual[i].household);
+        ASSERT_EQ(expected[i].timestamp, actual[i].timestamp);
+        ASSERT_EQ(expected[i].action, actual[i].action);
+    }
+
+    // Household 0 has a probe leak from sample 20 on
+    ASSERT_EQ(expected[0].household, 0u);
+    ASSERT_EQ(expected[0].timestamp, 200);
+    ASSERT_EQ(expected[0].action.getActionReason(), lg::ActionReason::LEAK_DETECTED_BY_PROBE);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include "leakguard/flow_episode_index.hpp"
+#include "leakguard/leak_logic.hpp"
+#include <gtest/gtest.h>
+
+#include <random>
+
+TEST(FlowEpisodeIndexTests, ShouldIndexNestedEpisodes) {
+    const std::vector<float> flowRates { 0, 5, 5, 2, 5, 0 };
+    const lg::FlowEpisodeIndex index(flowRates, 10, 1000);
+
+    // Whole series at 0, [1, 4] at 2, [1, 2] and [4] at 5
+    ASSERT_EQ(index.getEpisodes().size(), 4u);
+    ASSERT_EQ(index.query(4.0f, 20), 1020);
+    ASSERT_EQ(index.query(2.0f, 40), 1040);
+    ASSERT_EQ(index.query(2.0f, 41), std::nullopt);
+    ASSERT_EQ(index.query(0.0f, 0), 1000);
+}
+
+TEST(FlowEpisodeIndexTests, ShouldMatchCriterionReplay) {
+    std::mt19937 random(11);
+    std::uniform_int_distribution<int> flowSteps(0, 12);
+    std::vector<float> flowRates;
+    for (int i = 0; i < 500; i++) {
+        const float flowRate = static_cast<float>(flowSteps(random)) / 2.0f;
+        const int repeats = 1 + flowSteps(random);
+        flowRates.insert(flowRates.end(), repeats, flowRate);
+    }
+
+    constexpr time_t period = 15;
+    const lg::FlowEpisodeIndex index(flowRates, period, 500);
+    ASSERT_LT(index.getEpisodes().size(), flowRates.size());
+
+    const std::array<bool, 256> probeStates {};
+    for (const float threshold : { 0.0f, 0.5f, 1.75f, 3.0f, 5.5f, 6.0f, 7.0f }) {
+        for (const time_t duration : { 0, 1, 15, 16, 90, 200 }) {
+            lg::TimeBasedFlowRateCriterion criterion(threshold, duration);
+            std::optional<time_t> expected;
+            for (size_t i = 0; i < flowRates.size() && !expected; i++) {
+                criterion.update(lg::SensorState(flowRates[i], probeStates), period);
+                if (criterion.getAction())
+                    expected = 500 + static_cast<time_t>(i) * period;
+            }
+            ASSERT_EQ(index.query(threshold, duration), expected) << "threshold " << threshold << ", duration " << duration;
+        }
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "leakguard/flow_rate_batch.hpp"
+#include <gtest/gtest.h>
+
+#include <random>
+
+TEST(FlowRateBatchTests, ShouldDetectLeakPerHousehold) {
+    lg::FlowRateBatch batch(3);
+    batch.addRule(2.0f, 60);
+
+    const float flowRates[] = { 3, 0, 5 };
+    batch.update(flowRates, 30);
+    ASSERT_EQ(batch.getActionMask()[0], 0u);
+
+    batch.update(flowRates, 30);
+    ASSERT_TRUE(batch.shouldCloseValve(0));
+    ASSERT_FALSE(batch.shouldCloseValve(1));
+    ASSERT_TRUE(batch.shouldCloseValve(2));
+    ASSERT_EQ(batch.getAction(2).getActionReason(), lg::ActionReason::EXCEEDED_FLOW_RATE);
+}
+
+TEST(FlowRateBatchTests, ShouldMatchScalarCriteria) {
+    constexpr size_t households = 100;
+    lg::FlowRateBatch batch(households);
+    std::vector<lg::TimeBasedFlowRateCriterion> lowRule(households, lg::TimeBasedFlowRateCriterion(2.0f, 60));
+    std::vector<lg::TimeBasedFlowRateCriterion> highRule(households, lg::TimeBasedFlowRateCriterion(8.0f, 20));
+    batch.addRule(2.0f, 60);
+    batch.addRule(8.0f, 20);
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> flowDistribution(0.0f, 10.0f);
+    std::vector<float> flowRates(households);
+    const std::array<bool, 256> probeStates {};
+
+    for (int step = 0; step < 50; step++) {
+        for (auto& flowRate : flowRates)
+            flowRate = flowDistribution(random) < 1.5f ? 0.0f : flowDistribution(random);
+
+        batch.update(flowRates.data(), 10);
+
+        for (size_t i = 0; i < households; i++) {
+            lowRule[i].update(lg::SensorState(flowRates[i], probeStates), 10);
+            highRule[i].update(lg::SensorState(flowRates[i], probeStates), 10);
+
+            const bool expected = lowRule[i].getAction().has_value() || highRule[i].getAction().has_value();
+            ASSERT_EQ(batch.shouldCloseValve(i), expected);
+        }
+    }
+}
+
+TEST(FlowRateBatchTests, KernelsShouldBeBitIdentical) {
+    constexpr size_t lanes = 203;
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> quarterLiters(0, 40);
+    std::uniform_int_distribution<int> durations(0, 90);
+
+    std::vector<float> thresholds(lanes);
+    std::vector<time_t> minDurations(lanes);
+    for (size_t i = 0; i < lanes; i++) {
+        thresholds[i] = static_cast<float>(quarterLiters(random)) / 4.0f;
+        minDurations[i] = durations(random);
+    }
+
+    for (const auto type : { lg::FlowRateKernelType::SSE42, lg::FlowRateKernelType::AVX2 }) {
+        if (!lg::isFlowRateKernelSupported(type))
+            continue;
+
+        const lg::FlowRateKernel kernel = lg::getFlowRateKernel(type);
+        std::vector<time_t> expectedTimes(lanes), actualTimes(lanes);
+        std::vector<uint8_t> expectedActive(lanes), actualActive(lanes);
+        std::vector<uint64_t> expectedMask(4), actualMask(4);
+        std::vector<float> flowRates(lanes);
+
+        for (int step = 0; step < 30; step++) {
+            for (auto& flowRate : flowRates)
+                flowRate = static_cast<float>(quarterLiters(random)) / 4.0f;
+            flowRates[step] = std::nanf("");
+
+            lg::detail::flowRateKernelScalar(flowRates.data(), thresholds.data(), minDurations.data(),
+                expectedTimes.data(), expectedActive.data(), lanes, 10, expectedMask.data());
+            kernel(flowRates.data(), thresholds.data(), minDurations.data(),
+                actualTimes.data(), actualActive.data(), lanes, 10, actualMask.data());
+
+            ASSERT_EQ(expectedTimes, actualTimes);
+            ASSERT_EQ(expectedActive, actualActive);
+            ASSERT_EQ(expectedMask, actualMask);
+        }
+    }
+}
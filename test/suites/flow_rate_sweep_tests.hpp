@@ -0,0 +1,77 @@
+#pragma once
+#include "leakguard/flow_rate_sweep.hpp"
+#include <gtest/gtest.h>
+
+#include <random>
+
+TEST(FlowRateSweepTests, ShouldMatchIndividualCriteria) {
+    const std::vector<float> thresholds { 4.0f, 0.5f, 2.0f, 2.0f, 0.0f, 8.0f, 3.0f };
+    const std::vector<time_t> durations { 600, 0, 60, 10, 300, 60 };
+
+    std::mt19937 random(3);
+    std::uniform_int_distribution<int> flowSteps(0, 20);
+    std::uniform_int_distribution<int> elapsedSteps(0, 30);
+    std::vector<std::pair<float, time_t>> series;
+    for (int i = 0; i < 3000; i++) {
+        const float flowRate = static_cast<float>(flowSteps(random)) / 4.0f;
+        const int repeats = 1 + flowSteps(random);
+        for (int r = 0; r < repeats; r++)
+            series.emplace_back(flowRate, elapsedSteps(random));
+    }
+
+    lg::FlowRateSweep sweep(thresholds, durations);
+    for (const auto& [flowRate, elapsedTime] : series)
+        sweep.feed(flowRate, elapsedTime);
+
+    const std::array<bool, 256> probeStates {};
+    for (size_t t = 0; t < thresholds.size(); t++) {
+        for (size_t d = 0; d < durations.size(); d++) {
+            lg::TimeBasedFlowRateCriterion criterion(thresholds[t], durations[d]);
+            time_t clock = 0;
+            time_t expected = lg::FlowRateSweep::NOT_TRIPPED;
+            for (const auto& [flowRate, elapsedTime] : series) {
+                clock += elapsedTime;
+                criterion.update(lg::SensorState(flowRate, probeStates), elapsedTime);
+                if (criterion.getAction()) {
+                    expected = clock;
+                    break;
+                }
+            }
+            ASSERT_EQ(sweep.getFirstTrip(t, d), expected) << "threshold " << thresholds[t] << ", duration " << durations[d];
+        }
+    }
+}
+
+TEST(FlowRateSweepTests, ShouldReportSampleTimestamps) {
+    const std::vector<float> thresholds { 2.0f, 5.0f };
+    const std::vector<time_t> durations { 20 };
+    lg::FlowRateSweep sweep(thresholds, durations);
+
+    for (time_t t = 1000; t <= 1100; t += 10)
+        sweep.feed(lg::ReplaySample { t, 3.0f });
+
+    ASSERT_EQ(sweep.getFirstTrip(0, 0), 1020);
+    ASSERT_EQ(sweep.getFirstTrip(1, 0), lg::FlowRateSweep::NOT_TRIPPED);
+}
+
+TEST(FlowRateSweepTests, NaNShouldReachNoThreshold) {
+    const std::vector<float> thresholds { 0.0f, 2.0f };
+    const std::vector<time_t> durations { 10, 30 };
+    lg::FlowRateSweep sweep(thresholds, durations);
+
+    for (time_t t = 0; t <= 100; t += 10)
+        sweep.feed(lg::ReplaySample { t, std::nanf("") });
+
+    for (size_t t = 0; t < thresholds.size(); t++) {
+        for (size_t d = 0; d < durations.size(); d++)
+            ASSERT_EQ(sweep.getFirstTrip(t, d), lg::FlowRateSweep::NOT_TRIPPED);
+    }
+
+    // A NaN sample resets the accumulated time, as it does for the criterion
+    sweep.feed(lg::ReplaySample { 110, 3.0f });
+    sweep.feed(lg::ReplaySample { 120, 3.0f });
+    sweep.feed(lg::ReplaySample { 130, std::nanf("") });
+    sweep.feed(lg::ReplaySample { 140, 3.0f });
+    ASSERT_EQ(sweep.getFirstTrip(1, 0), 110);
+    ASSERT_EQ(sweep.getFirstTrip(1, 1), lg::FlowRateSweep::NOT_TRIPPED);
+}
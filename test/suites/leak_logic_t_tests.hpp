@@ -0,0 +1,44 @@
+#pragma once
+#include "leakguard/leak_logic_t.hpp"
+#include <gtest/gtest.h>
+
+using StaticLeakLogic = lg::LeakLogicT<lg::TimeBasedFlowRateCriterion, lg::ProbeLeakDetectionCriterion>;
+
+TEST(LeakLogicTTests, ShouldDetectLeakWithFlowMeter) {
+    StaticLeakLogic logic;
+    std::array<bool, 256> probeStates {};
+
+    logic.emplaceCriterion<lg::TimeBasedFlowRateCriterion>(2.0f, 60);
+
+    logic.update(lg::SensorState(3, probeStates), 30);
+    ASSERT_EQ(logic.getAction().getActionType(), lg::ActionType::NO_ACTION);
+
+    logic.update(lg::SensorState(3, probeStates), 30);
+    ASSERT_EQ(logic.getAction().getActionType(), lg::ActionType::CLOSE_VALVE);
+    ASSERT_EQ(logic.getAction().getActionReason(), lg::ActionReason::EXCEEDED_FLOW_RATE);
+}
+
+TEST(LeakLogicTTests, ShouldMatchDynamicLogic) {
+    StaticLeakLogic staticLogic;
+    lg::LeakLogic dynamicLogic;
+    lg::ProbeMask probeStates;
+
+    staticLogic.emplaceCriterion<lg::TimeBasedFlowRateCriterion>(2.0f, 60);
+    staticLogic.emplaceCriterion<lg::TimeBasedFlowRateCriterion>(5.0f, 120);
+    dynamicLogic.emplaceCriterion<lg::TimeBasedFlowRateCriterion>(2.0f, 60);
+    dynamicLogic.emplaceCriterion<lg::TimeBasedFlowRateCriterion>(5.0f, 120);
+    ASSERT_STREQ(staticLogic.serialize().ToCStr(), dynamicLogic.serialize().ToCStr());
+
+    const float flowRates[] = { 6, 6, 1, 3, 3, 3, 0, 7, 7, 7, 7 };
+    for (size_t i = 0; i < std::size(flowRates); i++) {
+        if (i == 8)
+            probeStates.set(17);
+
+        staticLogic.update(lg::SensorState(flowRates[i], probeStates), 25);
+        dynamicLogic.update(lg::SensorState(flowRates[i], probeStates), 25);
+
+        ASSERT_EQ(staticLogic.getAction().getActionType(), dynamicLogic.getAction().getActionType());
+        ASSERT_EQ(staticLogic.getAction().getActionReason(), dynamicLogic.getAction().getActionReason());
+        ASSERT_EQ(staticLogic.timeUntilNextPossibleAction(), dynamicLogic.timeUntilNextPossibleAction());
+    }
+}
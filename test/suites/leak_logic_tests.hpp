@@ -2,6 +2,8 @@
 #include "leakguard/leak_logic.hpp"
 #include <gtest/gtest.h>
 
+#include <thread>
+
 TEST(LeakLogicTest, ShouldDetectLeakWithFlowMeter) {
     lg::LeakLogic logic;
     std::array<bool, 256> probeStates {};
@@ -79,4 +81,358 @@ TEST(LeakLogicTests, ShouldRespondToProbeSignal) {
     ASSERT_EQ(logic.getAction().getActionType(), lg::ActionType::CLOSE_VALVE);
     ASSERT_EQ(logic.getAction().getActionReason(), lg::ActionReason::LEAK_DETECTED_BY_PROBE);
     ASSERT_EQ(logic.getAction().getProbeId(), 42);
-}
\ No newline at end of file
+}
+
+TEST(LeakLogicTests, ShouldReportLowestWetProbe) {
+    lg::LeakLogic logic;
+    lg::ProbeMask probeStates;
+
+    probeStates.set(255);
+    probeStates.set(130);
+    probeStates.set(64);
+    logic.update(lg::SensorState(0, probeStates), 1);
+    ASSERT_EQ(logic.getAction().getProbeId(), 64);
+
+    probeStates.reset(64);
+    logic.update(lg::SensorState(0, probeStates), 1);
+    ASSERT_EQ(logic.getAction().getProbeId(), 130);
+
+    probeStates.clear();
+    logic.update(lg::SensorState(0, probeStates), 1);
+    ASSERT_EQ(logic.getAction().getActionType(), lg::ActionType::NO_ACTION);
+}
+
+TEST(LeakLogicTests, ShouldStoreEmplacedCriteriaInPlace) {
+    lg::LeakLogic logic;
+    std::array<bool, 256> probeStates {};
+
+    ASSERT_TRUE(logic.emplaceCriterion<lg::TimeBasedFlowRateCriterion>(10.0f, 10));
+    ASSERT_TRUE(logic.emplaceCriterion<lg::TimeBasedFlowRateCriterion>(2.0f, 60));
+    ASSERT_TRUE(logic.getCriteria()->isInPlace());
+
+    logic.update(lg::SensorState(3, probeStates), 30);
+
+    // Shifting the remaining criterion must carry its state along
+    logic.removeCriterion(0);
+    logic.update(lg::SensorState(3, probeStates), 30);
+    ASSERT_EQ(logic.getAction().getActionType(), lg::ActionType::CLOSE_VALVE);
+}
+
+TEST(LeakLogicTests, ShouldHandleIncrementalSensorEvents) {
+    lg::LeakLogic logic;
+    logic.addCriterion(std::make_unique<lg::TimeBasedFlowRateCriterion>(2.0f, 60));
+
+    logic.onFlowSample(3, 30);
+    ASSERT_EQ(logic.getAction().getActionType(), lg::ActionType::NO_ACTION);
+
+    logic.onProbeChanged(200, true);
+    logic.onProbeChanged(90, true);
+    ASSERT_EQ(logic.getAction().getActionReason(), lg::ActionReason::LEAK_DETECTED_BY_PROBE);
+    ASSERT_EQ(logic.getAction().getProbeId(), 90);
+
+    logic.onProbeChanged(90, false);
+    ASSERT_EQ(logic.getAction().getProbeId(), 200);
+
+    logic.onProbeChanged(200, false);
+    ASSERT_EQ(logic.getAction().getActionType(), lg::ActionType::NO_ACTION);
+
+    // Flow criterion kept accumulating while probes changed
+    logic.onFlowSample(3, 30);
+    ASSERT_EQ(logic.getAction().getActionReason(), lg::ActionReason::EXCEEDED_FLOW_RATE);
+    ASSERT_FALSE(logic.getSensorState().probeStates.any());
+}
+
+TEST(LeakLogicTests, ProbeCriteriaInListShouldFollowIncrementalProbeChanges) {
+    lg::LeakLogic logic;
+    logic.loadFromString("P,|");
+
+    std::array<bool, LEAK_LOGIC_MAX_PROBES> probes {};
+    probes[3] = true;
+    logic.update(lg::SensorState(0, probes), 1);
+    ASSERT_EQ(logic.getAction().getProbeId(), 3);
+
+    logic.onProbeChanged(3, false);
+    ASSERT_EQ(logic.getAction().getActionType(), lg::ActionType::NO_ACTION);
+    ASSERT_EQ(logic.timeUntilNextPossibleAction(), lg::LeakDetectionCriterion::NEVER);
+
+    logic.onProbeChanged(7, true);
+    ASSERT_EQ(logic.getAction().getProbeId(), 7);
+    ASSERT_EQ(logic.getCriteria()->get()->getAction()->getProbeId(), 7);
+}
+
+TEST(LeakLogicTests, ShouldDetectVolumeExceededWithinWindow) {
+    lg::LeakLogic logic;
+    std::array<bool, 256> probeStates {};
+
+    // Detect leak if more than 20 liters flow within 10 minutes, in 1 minute buckets
+    logic.emplaceCriterion<lg::VolumeWindowCriterion>(20.0f, 600, 60);
+    logic.addCriterion(std::make_unique<lg::TimeBasedFlowRateCriterion>(2.0f, 60));
+
+    // Running toilet: 6 L/min for 30 seconds, then a 30 second pause
+    for (int cycle = 0; cycle < 6; cycle++) {
+        ASSERT_EQ(logic.getAction().getActionType(), lg::ActionType::NO_ACTION);
+        logic.update(lg::SensorState(6, probeStates), 30);
+        logic.update(lg::SensorState(0, probeStates), 30);
+    }
+
+    // 3 liters per cycle, 7th cycle exceeds 20 liters
+    logic.update(lg::SensorState(6, probeStates), 30);
+    ASSERT_EQ(logic.getAction().getActionReason(), lg::ActionReason::EXCEEDED_VOLUME);
+
+    // Volume leaves the window once flow stops for long enough
+    logic.update(lg::SensorState(0, probeStates), 600);
+    ASSERT_EQ(logic.getAction().getActionType(), lg::ActionType::NO_ACTION);
+}
+
+TEST(LeakLogicTests, VolumeWindowShouldNotDependOnStepSize) {
+    lg::VolumeWindowCriterion coarse(1000.0f, 300, 20);
+    lg::VolumeWindowCriterion fine(1000.0f, 300, 20);
+    std::array<bool, 256> probeStates {};
+
+    const std::pair<float, time_t> steps[] = { { 4.0f, 7 }, { 1.0f, 95 }, { 0.0f, 13 }, { 2.5f, 1000 }, { 3.0f, 61 } };
+    for (const auto& [flowRate, elapsedTime] : steps) {
+        coarse.update(lg::SensorState(flowRate, probeStates), elapsedTime);
+        for (time_t i = 0; i < elapsedTime; i++)
+            fine.update(lg::SensorState(flowRate, probeStates), 1);
+
+        ASSERT_NEAR(coarse.getVolume(), fine.getVolume(), 1e-3);
+    }
+    ASSERT_EQ(coarse.getBucketCount(), 15u);
+}
+
+TEST(LeakLogicTests, ShouldDetectLeakFromFlowMeterPulses) {
+    lg::LeakLogic logic;
+    logic.setPulseCalibration(450);
+
+    // 2 L/min for 1 minute, or more than 10 liters within 10 minutes
+    logic.emplaceCriterion<lg::TimeBasedFlowRateCriterion>(2.0f, 60);
+    logic.emplaceCriterion<lg::VolumeWindowCriterion>(10.0f, 600, 60);
+
+    // 14 pulses per second is just below 2 L/min
+    for (int i = 0; i < 120; i++)
+        logic.onPulseSample(14, 1);
+    ASSERT_EQ(logic.getAction().getActionType(), lg::ActionType::NO_ACTION);
+
+    // 15 pulses per second is exactly 2 L/min
+    for (int i = 0; i < 59; i++)
+        logic.onPulseSample(15, 1);
+    ASSERT_EQ(logic.getAction().getActionType(), lg::ActionType::NO_ACTION);
+    logic.onPulseSample(15, 1);
+    ASSERT_EQ(logic.getAction().getActionReason(), lg::ActionReason::EXCEEDED_FLOW_RATE);
+
+    // Short bursts never reach the rate threshold, but add up to more than 10 liters
+    logic.onPulseSample(0, 1);
+    auto criteria = logic.getCriteria();
+    ++criteria;
+    const auto& volume = static_cast<const lg::VolumeWindowCriterion&>(**criteria);
+    ASSERT_NEAR(volume.getVolume(), (120 * 14 + 60 * 15) / 450.0f, 1e-3);
+    logic.onPulseSample(3000, 30);
+    ASSERT_EQ(logic.getAction().getActionReason(), lg::ActionReason::EXCEEDED_VOLUME);
+    ASSERT_NEAR(volume.getVolume(), (120 * 14 + 60 * 15 + 3000) / 450.0f, 1e-3);
+}
+
+TEST(LeakLogicTests, PulseSampleWithoutElapsedTimeShouldNotExceedRate) {
+    lg::LeakLogic pulses;
+    pulses.setPulseCalibration(450);
+    pulses.loadFromString("T,200,0,|");
+
+    lg::LeakLogic flow;
+    flow.loadFromString("T,200,0,|");
+
+    pulses.onPulseSample(0, 0);
+    flow.onFlowSample(lg::flowRateFromPulses(0, 0, 450), 0);
+    ASSERT_EQ(pulses.getAction().getActionType(), lg::ActionType::NO_ACTION);
+    ASSERT_EQ(pulses.timeUntilNextPossibleAction(), lg::LeakDetectionCriterion::NEVER);
+    ASSERT_EQ(pulses.timeUntilNextPossibleAction(), flow.timeUntilNextPossibleAction());
+}
+
+TEST(LeakLogicTests, PulseSamplesShouldMatchFlowSamples) {
+    lg::LeakLogic pulses;
+    pulses.setPulseCalibration(330);
+    pulses.loadFromString("T,250,45,|V,800,300,20,|");
+
+    lg::LeakLogic flow;
+    flow.loadFromString("T,250,45,|V,800,300,20,|");
+
+    const std::pair<uint32_t, time_t> samples[] = {
+        { 100, 7 }, { 11, 1 }, { 2000, 95 }, { 0, 13 }, { 700, 61 }, { 15000, 1000 }, { 30, 1 }, { 60, 2 }
+    };
+    for (const auto& [count, elapsedTime] : samples) {
+        pulses.onPulseSample(count, elapsedTime);
+        flow.onFlowSample(lg::flowRateFromPulses(count, elapsedTime, 330), elapsedTime);
+        ASSERT_EQ(pulses.getAction(), flow.getAction());
+
+        auto pulseCriteria = pulses.getCriteria();
+        auto flowCriteria = flow.getCriteria();
+        ++pulseCriteria;
+        ++flowCriteria;
+        const auto& pulseVolume = static_cast<const lg::VolumeWindowCriterion&>(**pulseCriteria);
+        const auto& flowVolume = static_cast<const lg::VolumeWindowCriterion&>(**flowCriteria);
+        ASSERT_NEAR(pulseVolume.getVolume(), flowVolume.getVolume(), 1e-3);
+    }
+}
+
+TEST(LeakLogicTests, ShouldReportTimeUntilNextPossibleAction) {
+    lg::LeakLogic logic;
+    logic.emplaceCriterion<lg::TimeBasedFlowRateCriterion>(2.0f, 60);
+    logic.emplaceCriterion<lg::VolumeWindowCriterion>(10.0f, 600, 60);
+    ASSERT_EQ(logic.timeUntilNextPossibleAction(), lg::LeakDetectionCriterion::NEVER);
+
+    // Rate criterion trips after another 40 seconds, volume only after 10 liters
+    logic.onFlowSample(3.0f, 20);
+    ASSERT_EQ(logic.timeUntilNextPossibleAction(), 40);
+
+    // Below the rate threshold, only the volume can still trip: 9 more liters at 1.5 L/min
+    logic.onFlowSample(1.5f, 0);
+    ASSERT_EQ(logic.timeUntilNextPossibleAction(), 360);
+
+    // 0.5 L/min alone never adds up to 10 liters within 10 minutes
+    logic.onFlowSample(0.5f, 1200);
+    ASSERT_EQ(logic.timeUntilNextPossibleAction(), lg::LeakDetectionCriterion::NEVER);
+
+    logic.onFlowSample(0.0f, 5);
+    ASSERT_EQ(logic.timeUntilNextPossibleAction(), lg::LeakDetectionCriterion::NEVER);
+
+    logic.onProbeChanged(3, true);
+    ASSERT_EQ(logic.timeUntilNextPossibleAction(), 0);
+}
+
+TEST(LeakLogicTests, VolumeWindowShouldPredictTripTime) {
+    std::array<bool, 256> probeStates {};
+    const std::pair<float, time_t> history[] = { { 4.0f, 7 }, { 1.0f, 95 }, { 0.5f, 13 } };
+
+    for (const float flowRate : { 0.5f, 1.0f, 1.5f, 3.0f, 8.0f }) {
+        lg::VolumeWindowCriterion criterion(4.0f, 300, 20);
+        for (const auto& [rate, elapsedTime] : history)
+            criterion.update(lg::SensorState(rate, probeStates), elapsedTime);
+
+        criterion.update(lg::SensorState(flowRate, probeStates), 0);
+        const time_t predicted = criterion.timeUntilAction();
+
+        time_t actual = 0;
+        while (!criterion.getAction() && actual < 2000) {
+            criterion.update(lg::SensorState(flowRate, probeStates), 1);
+            actual++;
+        }
+
+        if (predicted == lg::LeakDetectionCriterion::NEVER)
+            ASSERT_FALSE(criterion.getAction()) << flowRate;
+        else
+            ASSERT_EQ(predicted, actual) << flowRate;
+    }
+}
+
+TEST(LeakLogicTests, AdvanceShouldMatchSmallSteps) {
+    lg::LeakLogic stepped;
+    lg::LeakLogic advanced;
+    stepped.loadFromString("T,200,3600,|V,50000,7200,300,|");
+    advanced.loadFromString("T,200,3600,|V,50000,7200,300,|");
+
+    lg::ProbeMask probeStates;
+    const std::pair<float, time_t> spans[] = { { 2.5f, 17 }, { 0.0f, 20000 }, { 3.0f, 3599 }, { 3.0f, 1 }, { 6.0f, 5000 } };
+    for (const auto& [flowRate, duration] : spans) {
+        for (time_t i = 0; i < duration; i++)
+            stepped.update(lg::SensorState(flowRate, probeStates), 1);
+        advanced.advance(lg::SensorState(flowRate, probeStates), duration);
+
+        ASSERT_EQ(stepped.getAction(), advanced.getAction());
+        ASSERT_EQ(stepped.timeUntilNextPossibleAction(), advanced.timeUntilNextPossibleAction());
+
+        auto steppedCriteria = stepped.getCriteria();
+        auto advancedCriteria = advanced.getCriteria();
+        ++steppedCriteria;
+        ++advancedCriteria;
+        ASSERT_NEAR(static_cast<const lg::VolumeWindowCriterion&>(**steppedCriteria).getVolume(),
+                    static_cast<const lg::VolumeWindowCriterion&>(**advancedCriteria).getVolume(), 1e-2);
+    }
+    ASSERT_EQ(advanced.getAction().getActionReason(), lg::ActionReason::EXCEEDED_FLOW_RATE);
+}
+
+TEST(LeakLogicTests, ShouldTrackActionGeneration) {
+    lg::LeakLogic logic;
+    logic.emplaceCriterion<lg::TimeBasedFlowRateCriterion>(2.0f, 60);
+    const uint32_t initial = logic.getActionGeneration();
+
+    logic.onFlowSample(3.0f, 30);
+    ASSERT_EQ(logic.getActionGeneration(), initial);
+
+    logic.onFlowSample(3.0f, 30);
+    ASSERT_EQ(logic.getAction().getActionReason(), lg::ActionReason::EXCEEDED_FLOW_RATE);
+    ASSERT_EQ(logic.getActionGeneration(), initial + 1);
+
+    // Same action, different reason to report
+    logic.onProbeChanged(4, true);
+    logic.onFlowSample(0.0f, 1);
+    ASSERT_EQ(logic.getAction().getActionReason(), lg::ActionReason::LEAK_DETECTED_BY_PROBE);
+    ASSERT_EQ(logic.getActionGeneration(), initial + 2);
+
+    logic.onProbeChanged(4, false);
+    ASSERT_EQ(logic.getAction().getActionType(), lg::ActionType::NO_ACTION);
+    ASSERT_EQ(logic.getActionGeneration(), initial + 3);
+
+    // Reconfiguration is reflected immediately
+    logic.onFlowSample(3.0f, 120);
+    logic.clearCriteria();
+    ASSERT_EQ(logic.getAction().getActionType(), lg::ActionType::NO_ACTION);
+    ASSERT_EQ(logic.getActionGeneration(), initial + 5);
+}
+
+TEST(LeakLogicTests, PublishedCriteriaShouldKeepMatchingState) {
+    lg::LeakLogic logic;
+    logic.loadFromString("T,200,60,|V,1000,600,60,|T,100,600,|");
+    logic.onFlowSample(3.0f, 45);
+
+    auto next = std::make_unique<lg::CriteriaSet>();
+    ASSERT_TRUE(next->loadFromString("V,1000,600,60,|T,500,600,|T,200,60,|"));
+    logic.publishCriteria(std::move(next));
+
+    // Not adopted before the next update
+    ASSERT_STREQ(logic.serialize().ToCStr(), "T,200,60,|V,1000,600,60,|T,100,600,|");
+    ASSERT_EQ(logic.reclaimRetiredCriteria(), 0u);
+
+    logic.onFlowSample(3.0f, 15);
+    ASSERT_STREQ(logic.serialize().ToCStr(), "V,1000,600,60,|T,500,600,|T,200,60,|");
+    ASSERT_EQ(logic.getAction().getActionReason(), lg::ActionReason::EXCEEDED_FLOW_RATE);
+
+    auto criteria = logic.getCriteria();
+    ASSERT_EQ((*criteria)->getAccumulated(), 300);
+    ++criteria;
+    ASSERT_EQ((*criteria)->getAccumulated(), 0);
+    ++criteria;
+    ASSERT_EQ((*criteria)->getAccumulated(), 60);
+
+    ASSERT_EQ(logic.reclaimRetiredCriteria(), 1u);
+    ASSERT_FALSE(logic.adoptPublishedCriteria());
+}
+
+TEST(LeakLogicTests, ShouldAdoptCriteriaPublishedConcurrently) {
+    constexpr int PUBLISH_COUNT = 2000;
+    lg::LeakLogic logic;
+    logic.loadFromString("T,200,60,|");
+    std::atomic<bool> done { false };
+
+    std::thread publisher([&] {
+        for (int i = 0; i < PUBLISH_COUNT; i++) {
+            auto next = std::make_unique<lg::CriteriaSet>();
+            next->loadFromString(i % 2 == 0 ? "T,200,60,|V,1000,600,60,|" : "T,200,60,|");
+            next->addCriterion(std::make_unique<lg::TimeBasedFlowRateCriterion>(static_cast<float>(i), 10));
+            logic.publishCriteria(std::move(next));
+        }
+        done = true;
+    });
+
+    time_t elapsed = 0;
+    while (!done) {
+        logic.onFlowSample(3.0f, 1);
+        elapsed++;
+        std::this_thread::yield();
+    }
+    publisher.join();
+    logic.onFlowSample(3.0f, 1);
+    elapsed++;
+    logic.reclaimRetiredCriteria();
+
+    // The rate criterion never changed, so it kept accumulating through every swap
+    ASSERT_EQ((*logic.getCriteria())->getAccumulated(), elapsed);
+    ASSERT_STREQ(logic.serialize().ToCStr(), "T,200,60,|T,199900,10,|");
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "leakguard/sample_ring.hpp"
+#include <gtest/gtest.h>
+
+#include <thread>
+
+TEST(SampleRingTests, ShouldQueueSamplesInOrder) {
+    lg::SampleRing<4> ring;
+    for (uint32_t i = 0; i < 4; i++)
+        ASSERT_TRUE(ring.push(lg::SensorSample::ofPulses(i, 1)));
+
+    ASSERT_FALSE(ring.push(lg::SensorSample::ofPulses(4, 1)));
+    ASSERT_EQ(ring.getDroppedCount(), 1u);
+    ASSERT_EQ(ring.getSize(), 4u);
+
+    lg::SensorSample sample;
+    ASSERT_TRUE(ring.pop(sample));
+    ASSERT_EQ(sample.pulses, 0u);
+    ASSERT_TRUE(ring.push(lg::SensorSample::ofPulses(5, 1)));
+
+    std::vector<uint32_t> consumed;
+    ASSERT_EQ(ring.consume([&](const lg::SensorSample& queued) { consumed.push_back(queued.pulses); }), 4u);
+    ASSERT_EQ(consumed, std::vector<uint32_t>({ 1, 2, 3, 5 }));
+    ASSERT_FALSE(ring.pop(sample));
+}
+
+TEST(SampleRingTests, DrainShouldMatchDirectCalls) {
+    lg::LeakLogic direct;
+    lg::LeakLogic drained;
+    direct.loadFromString("T,200,60,|V,1000,600,60,|");
+    drained.loadFromString("T,200,60,|V,1000,600,60,|");
+
+    lg::SampleRing<> ring;
+    for (int second = 0; second < 90; second++) {
+        ring.push(lg::SensorSample::ofFlowRate(3.0f, 1));
+        direct.onFlowSample(3.0f, 1);
+
+        if (second == 30) {
+            ring.push(lg::SensorSample::ofProbe(9, true));
+            ring.push(lg::SensorSample::ofProbe(9, false));
+            direct.onProbeChanged(9, true);
+            direct.onProbeChanged(9, false);
+        }
+
+        // Main loop only gets to run every few seconds
+        if (second % 7 == 0) {
+            drained.drain(ring);
+            ASSERT_EQ(drained.getAction(), direct.getAction());
+        }
+    }
+    drained.drain(ring);
+
+    ASSERT_EQ(drained.getAction().getActionReason(), lg::ActionReason::EXCEEDED_FLOW_RATE);
+    ASSERT_EQ(drained.getAction(), direct.getAction());
+    ASSERT_EQ(drained.getSensorState().flowRate, direct.getSensorState().flowRate);
+    ASSERT_EQ(ring.getDroppedCount(), 0u);
+}
+
+TEST(SampleRingTests, ShouldHandOverSamplesBetweenThreads) {
+    constexpr uint32_t SAMPLE_COUNT = 200000;
+    lg::SampleRing<16> ring;
+
+    std::thread producer([&] {
+        for (uint32_t i = 0; i < SAMPLE_COUNT; i++) {
+            while (!ring.push(lg::SensorSample::ofPulses(i, 1)))
+                std::this_thread::yield();
+        }
+    });
+
+    uint32_t expected = 0;
+    while (expected < SAMPLE_COUNT) {
+        const size_t consumed = ring.consume([&](const lg::SensorSample& sample) {
+            ASSERT_EQ(sample.pulses, expected);
+            expected++;
+        });
+        if (consumed == 0)
+            std::this_thread::yield();
+    }
+    producer.join();
+
+    ASSERT_EQ(ring.getSize(), 0u);
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "leakguard/leak_logic.hpp"
+#include "leakguard/seqlock.hpp"
+#include <gtest/gtest.h>
+
+#include <thread>
+
+TEST(SeqLockTests, ShouldPublishLeakLogicSnapshot) {
+    lg::LeakLogic logic;
+    logic.loadFromString("T,200,60,|V,1000,600,60,|");
+    lg::SeqLock<lg::LeakLogicSnapshot> published;
+
+    const uint32_t sequence = published.getSequence();
+    ASSERT_EQ(published.load().criterionCount, 0);
+
+    logic.onFlowSample(3.0f, 45);
+    logic.onProbeChanged(12, true);
+    published.store(logic.getSnapshot());
+    ASSERT_NE(published.getSequence(), sequence);
+
+    const lg::LeakLogicSnapshot snapshot = published.load();
+    ASSERT_EQ(snapshot.action.getActionReason(), lg::ActionReason::LEAK_DETECTED_BY_PROBE);
+    ASSERT_EQ(snapshot.actionGeneration, logic.getActionGeneration());
+    ASSERT_EQ(snapshot.flowRate, 3.0f);
+    ASSERT_TRUE(snapshot.probeStates.test(12));
+    ASSERT_EQ(snapshot.criterionCount, 2);
+
+    ASSERT_EQ(snapshot.criteria[0].action.getActionType(), lg::ActionType::NO_ACTION);
+    ASSERT_EQ(snapshot.criteria[0].accumulated, 45);
+    ASSERT_EQ(snapshot.criteria[0].timeUntilAction, 15);
+    ASSERT_EQ(snapshot.criteria[1].accumulated, 225);
+}
+
+TEST(SeqLockTests, ReadersShouldNeverSeeTornValues) {
+    struct Payload {
+        uint64_t values[16];
+    };
+
+    constexpr uint64_t STORE_COUNT = 100000;
+    lg::SeqLock<Payload> published;
+    std::atomic<bool> done { false };
+
+    std::thread writer([&] {
+        Payload payload {};
+        for (uint64_t i = 1; i <= STORE_COUNT; i++) {
+            for (uint64_t& value : payload.values)
+                value = i;
+            published.store(payload);
+        }
+        done = true;
+    });
+
+    std::vector<std::thread> readers;
+    std::atomic<int> failures { 0 };
+    for (int reader = 0; reader < 3; reader++) {
+        readers.emplace_back([&] {
+            uint64_t last = 0;
+            while (!done) {
+                Payload payload;
+                if (!published.tryLoad(payload)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                for (const uint64_t value : payload.values)
+                    failures += value != payload.values[0];
+                failures += payload.values[0] < last;
+                last = payload.values[0];
+            }
+        });
+    }
+
+    writer.join();
+    for (auto& reader : readers)
+        reader.join();
+
+    ASSERT_EQ(failures.load(), 0);
+    ASSERT_EQ(published.load().values[15], STORE_COUNT);
+}
@@ -29,4 +29,283 @@ TEST(SerializationTests, ShouldDeserializeMultipleCriteria) {
     logic.loadFromString("T,200,60,|T,500,120,|");
     const auto serialized = logic.serialize();
     ASSERT_STREQ(serialized.ToCStr(), "T,200,60,|T,500,120,|");
-}
\ No newline at end of file
+}
+
+TEST(SerializationTests, ShouldComputeCrc32) {
+    const char* check = "123456789";
+    ASSERT_EQ(lg::crc32(reinterpret_cast<const uint8_t*>(check), 9), 0xCBF43926u);
+}
+
+TEST(SerializationTests, ShouldRoundTripBinaryConfiguration) {
+    lg::LeakLogic logic;
+    logic.addCriterion(std::make_unique<lg::TimeBasedFlowRateCriterion>(2.0f, 60));
+    logic.addCriterion(std::make_unique<lg::TimeBasedFlowRateCriterion>(5.0f, 120));
+
+    uint8_t buffer[64];
+    const size_t length = logic.serializeBinary(buffer, sizeof(buffer));
+    // Header, two 10-byte records, CRC
+    ASSERT_EQ(length, 4u + 2 * 10 + 4);
+    ASSERT_EQ(logic.serializeBinary(buffer, length - 1), 0u);
+    logic.serializeBinary(buffer, sizeof(buffer));
+
+    const lg::BinaryConfigView view(buffer, length);
+    ASSERT_TRUE(view.isValid());
+    ASSERT_EQ(view.getCount(), 2u);
+    ASSERT_EQ((*view.begin()).type, 'T');
+
+    lg::LeakLogic loaded;
+    ASSERT_TRUE(loaded.loadFromBinary(view));
+    ASSERT_STREQ(loaded.serialize().ToCStr(), "T,200,60,|T,500,120,|");
+}
+
+TEST(SerializationTests, ShouldRejectCorruptedBinaryConfiguration) {
+    lg::LeakLogic logic;
+    logic.addCriterion(std::make_unique<lg::TimeBasedFlowRateCriterion>(2.0f, 60));
+
+    uint8_t buffer[32];
+    const size_t length = logic.serializeBinary(buffer, sizeof(buffer));
+    buffer[6] ^= 0x01;
+
+    lg::LeakLogic loaded;
+    loaded.addCriterion(std::make_unique<lg::TimeBasedFlowRateCriterion>(5.0f, 120));
+    ASSERT_FALSE(loaded.loadFromBinary(buffer, length));
+    ASSERT_FALSE(loaded.loadFromBinary(buffer, length - 1));
+    ASSERT_STREQ(loaded.serialize().ToCStr(), "T,500,120,|");
+}
+
+TEST(SerializationTests, ShouldDeserializeProbeCriterion) {
+    lg::LeakLogic logic;
+    ASSERT_TRUE(logic.loadFromString("T,200,60,|P,|"));
+    ASSERT_STREQ(logic.serialize().ToCStr(), "T,200,60,|P,|");
+}
+
+TEST(SerializationTests, ShouldReportParseErrorOffset) {
+    lg::LeakLogic logic;
+
+    auto result = logic.loadFromString("T,200,60,|T,5x0,120,|");
+    ASSERT_EQ(result.error, lg::ParseError::UNEXPECTED_CHARACTER);
+    ASSERT_EQ(result.offset, 13u);
+    ASSERT_STREQ(logic.serialize().ToCStr(), "T,200,60,|");
+
+    result = logic.loadFromString("T,200,60,|T,500");
+    ASSERT_EQ(result.error, lg::ParseError::INCOMPLETE_RECORD);
+    ASSERT_EQ(result.offset, 15u);
+
+    result = logic.loadFromString("T,200,|");
+    ASSERT_EQ(result.error, lg::ParseError::INVALID_RECORD);
+    ASSERT_EQ(result.offset, 6u);
+}
+
+TEST(SerializationTests, ShouldSkipUnknownCriteria) {
+    lg::LeakLogic logic;
+    ASSERT_TRUE(logic.loadFromString("T,200,60,|X,1,2,|Z,|P,|"));
+    ASSERT_STREQ(logic.serialize().ToCStr(), "T,200,60,|P,|");
+}
+
+TEST(SerializationTests, ShouldParseConfigurationInChunks) {
+    const std::string_view serialized = "T,200,60,|P,|T,-150,3600,|";
+
+    for (size_t chunkSize = 1; chunkSize <= serialized.size(); chunkSize++) {
+        lg::LeakLogic logic;
+        lg::ConfigParser parser;
+        const auto onRecord = [&](const lg::ParsedCriterion& parsed) { return logic.addParsedCriterion(parsed); };
+
+        for (size_t i = 0; i < serialized.size(); i += chunkSize)
+            ASSERT_TRUE(parser.feed(serialized.substr(i, chunkSize), onRecord));
+
+        ASSERT_TRUE(parser.finish());
+        ASSERT_STREQ(logic.serialize().ToCStr(), "T,200,60,|P,|T,-150,3600,|");
+    }
+}
+
+TEST(SerializationTests, ShouldResumeDetectionFromCheckpoint) {
+    lg::LeakLogic logic;
+    logic.loadFromString("T,200,60,|T,500,600,|");
+    logic.onFlowSample(3, 45);
+    logic.onProbeChanged(7, true);
+
+    uint8_t buffer[128];
+    const size_t length = logic.saveCheckpoint(buffer, sizeof(buffer));
+    ASSERT_GT(length, 0u);
+    ASSERT_EQ(logic.saveCheckpoint(buffer, length - 1), 0u);
+    logic.saveCheckpoint(buffer, sizeof(buffer));
+
+    lg::LeakLogic restored;
+    ASSERT_TRUE(restored.restoreCheckpoint(buffer, length));
+    ASSERT_STREQ(restored.serialize().ToCStr(), "T,200,60,|T,500,600,|");
+    ASSERT_EQ(restored.getAction().getProbeId(), 7);
+    ASSERT_TRUE(restored.getSensorState().probeStates.test(7));
+
+    // Only the remaining 15 seconds of the grace period are left
+    restored.onProbeChanged(7, false);
+    restored.onFlowSample(3, 15);
+    ASSERT_EQ(restored.getAction().getActionReason(), lg::ActionReason::EXCEEDED_FLOW_RATE);
+
+    buffer[length / 2] ^= 0x10;
+    lg::LeakLogic corrupted;
+    ASSERT_FALSE(corrupted.restoreCheckpoint(buffer, length));
+    ASSERT_STREQ(corrupted.serialize().ToCStr(), "");
+}
+
+TEST(SerializationTests, ShouldDropStateOfCheckpointFromOtherBuild) {
+    lg::LeakLogic logic;
+    logic.loadFromString("T,200,60,|");
+    logic.onProbeChanged(7, true);
+
+    uint8_t buffer[128];
+    const size_t length = logic.saveCheckpoint(buffer, sizeof(buffer));
+    ASSERT_GT(length, 0u);
+
+    // Flip the number format flag, as if written by a fixed-point build (or vice versa), keeping the CRC valid
+    buffer[3] ^= 0x01;
+    lg::BinaryWriter crcWriter(buffer + length - 4, 4);
+    crcWriter.writeU32(lg::crc32(buffer, length - 4));
+
+    lg::LeakLogic restored;
+    restored.onProbeChanged(3, true);
+    ASSERT_FALSE(restored.restoreCheckpoint(buffer, length));
+    ASSERT_STREQ(restored.serialize().ToCStr(), "T,200,60,|");
+    ASSERT_EQ(restored.getAction().getActionType(), lg::ActionType::NO_ACTION);
+    ASSERT_FALSE(restored.getSensorState().probeStates.any());
+}
+
+TEST(SerializationTests, ShouldRoundTripVolumeWindowCriterion) {
+    lg::LeakLogic logic;
+    ASSERT_TRUE(logic.loadFromString("V,2050,3600,300,|T,200,60,|"));
+    ASSERT_STREQ(logic.serialize().ToCStr(), "V,2050,3600,300,|T,200,60,|");
+
+    const auto criterion = lg::VolumeWindowCriterion::deserialize("V,2050,3600,300,");
+    ASSERT_NEAR(criterion->getMaxVolume(), 20.5, 0.01);
+    ASSERT_EQ(criterion->getWindow(), 3600);
+    ASSERT_EQ(criterion->getBucketWidth(), 300);
+
+    // Window needs more buckets than available, so they get wider
+    ASSERT_EQ(lg::VolumeWindowCriterion(10.0f, 3600, 60).getBucketWidth(), 3600 / LEAK_LOGIC_VOLUME_MAX_BUCKETS);
+
+    logic.onFlowSample(5.0f, 1000);
+    uint8_t buffer[256];
+    const size_t length = logic.saveCheckpoint(buffer, sizeof(buffer));
+    ASSERT_GT(length, 0u);
+
+    lg::LeakLogic restored;
+    ASSERT_TRUE(restored.restoreCheckpoint(buffer, length));
+    ASSERT_STREQ(restored.serialize().ToCStr(), "V,2050,3600,300,|T,200,60,|");
+    ASSERT_EQ(restored.getAction().getActionReason(), lg::ActionReason::EXCEEDED_VOLUME);
+}
+
+namespace {
+    /**
+     * @brief Start a patch against a configuration hash; the operation count is patched in by finishPatch().
+     */
+    lg::BinaryWriter beginPatch(uint8_t* buffer, const size_t capacity, const uint32_t baseHash) {
+        lg::BinaryWriter writer(buffer, capacity);
+        writer.writeU8('L');
+        writer.writeU8('P');
+        writer.writeU8(LEAK_LOGIC_BINARY_VERSION);
+        writer.writeU8(0);
+        writer.writeU32(baseHash);
+        return writer;
+    }
+
+    size_t finishPatch(lg::BinaryWriter& writer, const uint8_t operationCount) {
+        writer.patchU8(3, operationCount);
+        writer.writeU32(lg::crc32(writer.getBuffer(), writer.getLength()));
+        return writer.getLength();
+    }
+
+    void writeTimeBasedRecord(lg::BinaryWriter& writer, const int32_t centiThreshold, const uint32_t minDuration) {
+        writer.beginRecord('T');
+        writer.writeI32(centiThreshold);
+        writer.writeU32(minDuration);
+        writer.endRecord();
+    }
+}
+
+TEST(SerializationTests, ShouldHashBinaryConfiguration) {
+    lg::LeakLogic logic;
+    logic.loadFromString("T,200,60,|T,500,600,|");
+
+    uint8_t buffer[64];
+    const size_t length = logic.serializeBinary(buffer, sizeof(buffer));
+    ASSERT_EQ(logic.getConfigHash(), lg::BinaryConfigView(buffer, length).getCrc());
+
+    lg::LeakLogic same;
+    same.loadFromBinary(buffer, length);
+    ASSERT_EQ(same.getConfigHash(), logic.getConfigHash());
+
+    same.loadFromString("T,200,60,|T,500,601,|");
+    ASSERT_NE(same.getConfigHash(), logic.getConfigHash());
+}
+
+TEST(SerializationTests, ShouldApplyConfigurationPatchInPlace) {
+    lg::LeakLogic logic;
+    logic.loadFromString("T,200,60,|T,500,600,|");
+    logic.onFlowSample(6, 45);
+
+    uint8_t buffer[64];
+    auto writer = beginPatch(buffer, sizeof(buffer), logic.getConfigHash());
+    writer.writeU8(static_cast<uint8_t>(lg::PatchOperation::REPLACE));
+    writer.writeU8(0);
+    writeTimeBasedRecord(writer, 300, 1000);
+    writer.writeU8(static_cast<uint8_t>(lg::PatchOperation::ADD));
+    writer.writeU8(0);
+    writer.beginRecord('P');
+    writer.endRecord();
+    writer.writeU8(static_cast<uint8_t>(lg::PatchOperation::ADD));
+    writer.writeU8(3);
+    writeTimeBasedRecord(writer, 100, 7200);
+    writer.writeU8(static_cast<uint8_t>(lg::PatchOperation::REMOVE));
+    writer.writeU8(3);
+    const size_t length = finishPatch(writer, 4);
+
+    ASSERT_TRUE(logic.applyPatch(buffer, length));
+    ASSERT_STREQ(logic.serialize().ToCStr(), "P,|T,300,1000,|T,500,600,|");
+
+    // Applying the same patch again does not match the new configuration
+    ASSERT_FALSE(logic.applyPatch(buffer, length));
+
+    // The untouched criterion kept its 45 seconds, the replaced one starts over
+    logic.onFlowSample(6, 555);
+    ASSERT_EQ(logic.getAction().getActionReason(), lg::ActionReason::EXCEEDED_FLOW_RATE);
+    auto criterion = logic.getCriteria();
+    ++criterion;
+    ASSERT_EQ((*criterion)->getAccumulated(), 555);
+}
+
+TEST(SerializationTests, ShouldRejectInvalidConfigurationPatch) {
+    lg::LeakLogic logic;
+    logic.loadFromString("T,200,60,|");
+    const uint32_t hash = logic.getConfigHash();
+
+    uint8_t buffer[64];
+    auto writer = beginPatch(buffer, sizeof(buffer), hash + 1);
+    writer.writeU8(static_cast<uint8_t>(lg::PatchOperation::REMOVE));
+    writer.writeU8(0);
+    ASSERT_FALSE(logic.applyPatch(buffer, finishPatch(writer, 1)));
+
+    // The first operation is fine, but the second one is out of range, so neither is applied
+    writer = beginPatch(buffer, sizeof(buffer), hash);
+    writer.writeU8(static_cast<uint8_t>(lg::PatchOperation::REPLACE));
+    writer.writeU8(0);
+    writeTimeBasedRecord(writer, 300, 60);
+    writer.writeU8(static_cast<uint8_t>(lg::PatchOperation::REMOVE));
+    writer.writeU8(1);
+    ASSERT_FALSE(logic.applyPatch(buffer, finishPatch(writer, 2)));
+
+    writer = beginPatch(buffer, sizeof(buffer), hash);
+    writer.writeU8(static_cast<uint8_t>(lg::PatchOperation::ADD));
+    writer.writeU8(1);
+    writer.beginRecord('X');
+    writer.endRecord();
+    ASSERT_FALSE(logic.applyPatch(buffer, finishPatch(writer, 1)));
+
+    writer = beginPatch(buffer, sizeof(buffer), hash);
+    writer.writeU8(static_cast<uint8_t>(lg::PatchOperation::REMOVE));
+    writer.writeU8(0);
+    const size_t length = finishPatch(writer, 1);
+    buffer[9] ^= 0x01;
+    ASSERT_FALSE(logic.applyPatch(buffer, length));
+
+    ASSERT_STREQ(logic.serialize().ToCStr(), "T,200,60,|");
+    ASSERT_EQ(logic.getConfigHash(), hash);
+}
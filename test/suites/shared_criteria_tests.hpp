@@ -0,0 +1,109 @@
+#pragma once
+#include "leakguard/leak_logic.hpp"
+#include "leakguard/shared_criteria.hpp"
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace {
+    /**
+     * @brief Storage for count state blocks, suitably aligned.
+     */
+    std::vector<std::max_align_t> allocateStates(const lg::SharedCriteria& criteria, const size_t count) {
+        return std::vector<std::max_align_t>((count * criteria.getStateSize() + sizeof(std::max_align_t) - 1)
+            / sizeof(std::max_align_t));
+    }
+}
+
+TEST(SharedCriteriaTests, ShouldMatchLeakLogic) {
+    const char* configuration = "T,200,60,|V,2050,3600,300,|T,-150,3600,|P,|";
+    lg::LeakLogic logic;
+    logic.setPulseCalibration(450);
+    logic.loadFromString(configuration);
+
+    lg::SharedCriteriaPool pool;
+    const auto criteria = pool.intern(configuration);
+    ASSERT_NE(criteria, nullptr);
+    ASSERT_EQ(criteria->getCount(), 4u);
+
+    auto block = allocateStates(*criteria, 1);
+    lg::SharedLeakLogic shared(*criteria, block.data());
+    shared.reset();
+    shared.setPulseCalibration(450);
+
+    for (int i = 0; i < 400; i++) {
+        switch (i % 7) {
+            case 0:
+                logic.onProbeChanged(static_cast<uint8_t>(i % 5), i % 3 == 0);
+                shared.onProbeChanged(static_cast<uint8_t>(i % 5), i % 3 == 0);
+            break;
+            case 1:
+            case 2:
+                logic.onPulseSample(static_cast<uint32_t>(i * 7 % 3000), i % 13);
+                shared.onPulseSample(static_cast<uint32_t>(i * 7 % 3000), i % 13);
+            break;
+            default:
+                logic.onFlowSample(static_cast<lg::FlowRate>(i % 11), i % 17);
+                shared.onFlowSample(static_cast<lg::FlowRate>(i % 11), i % 17);
+            break;
+        }
+
+        ASSERT_EQ(shared.getAction(), logic.getAction()) << "sample " << i;
+        ASSERT_EQ(shared.timeUntilNextPossibleAction(), logic.timeUntilNextPossibleAction()) << "sample " << i;
+    }
+}
+
+TEST(SharedCriteriaTests, ShouldInternIdenticalConfigurations) {
+    lg::SharedCriteriaPool pool;
+    const auto first = pool.intern("T,200,60,|V,2050,3600,300,|");
+    const auto second = pool.intern("T,200,60,|V,2050,3600,300,|");
+    const auto other = pool.intern("T,200,61,|V,2050,3600,300,|");
+    ASSERT_EQ(first.get(), second.get());
+    ASSERT_NE(first.get(), other.get());
+    ASSERT_EQ(pool.intern("T,200,|"), nullptr);
+
+    lg::LeakLogic logic;
+    logic.loadFromString("T,200,60,|V,2050,3600,300,|");
+    uint8_t buffer[64];
+    const size_t length = logic.serializeBinary(buffer, sizeof(buffer));
+    ASSERT_EQ(pool.intern(lg::BinaryConfigView(buffer, length)).get(), first.get());
+    ASSERT_EQ(first->getConfigHash(), logic.getConfigHash());
+    ASSERT_EQ(pool.getSize(), 2u);
+
+    // Each household only needs its state block, packed next to the others
+    ASSERT_EQ(first->getStateSize() % lg::SharedCriteria::STATE_ALIGNMENT, 0u);
+    ASSERT_LT(first->getStateSize(), sizeof(lg::LeakLogic) / 4);
+
+    auto states = allocateStates(*first, 3);
+    auto* base = reinterpret_cast<unsigned char*>(states.data());
+    for (size_t household = 0; household < 3; household++)
+        lg::SharedLeakLogic(*first, base + household * first->getStateSize()).reset();
+
+    lg::SharedLeakLogic(*first, base + first->getStateSize()).onFlowSample(3, 60);
+    ASSERT_EQ(lg::SharedLeakLogic(*first, base).getAction().getActionType(), lg::ActionType::NO_ACTION);
+    ASSERT_EQ(lg::SharedLeakLogic(*first, base + first->getStateSize()).getAction().getActionReason(),
+        lg::ActionReason::EXCEEDED_FLOW_RATE);
+    ASSERT_EQ(lg::SharedLeakLogic(*first, base + 2 * first->getStateSize()).getAction().getActionType(),
+        lg::ActionType::NO_ACTION);
+}
+
+TEST(SharedCriteriaTests, ShouldKeepPulseCalibrationPerHousehold) {
+    lg::SharedCriteriaPool pool;
+    const auto criteria = pool.intern("T,200,60,|");
+    auto states = allocateStates(*criteria, 2);
+    auto* base = reinterpret_cast<unsigned char*>(states.data());
+    lg::SharedLeakLogic coarse(*criteria, base);
+    lg::SharedLeakLogic fine(*criteria, base + criteria->getStateSize());
+    coarse.reset();
+    fine.reset();
+    coarse.setPulseCalibration(100);
+    fine.setPulseCalibration(1000);
+    ASSERT_EQ(coarse.getPulseCalibration(), 100u);
+    ASSERT_EQ(fine.getPulseCalibration(), 1000u);
+
+    // 300 pulses per minute are 3 l/min at 100 pulses per liter, but only 0.3 l/min at 1000
+    coarse.onPulseSample(300, 60);
+    fine.onPulseSample(300, 60);
+    ASSERT_EQ(coarse.getAction().getActionReason(), lg::ActionReason::EXCEEDED_FLOW_RATE);
+    ASSERT_EQ(fine.getAction().getActionType(), lg::ActionType::NO_ACTION);
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "leakguard/telemetry_file.hpp"
+#include <gtest/gtest.h>
+
+TEST(TelemetryFileTests, ShouldRoundTripSamples) {
+    const std::vector<lg::ReplaySample> samples {
+        { 1000, 0.0f },
+        { 1010, 2.5f, 12, true },
+        { 1010, 3.25f },
+        { 1000000, 655.35f, 12, false },
+    };
+
+    lg::TelemetryWriter writer;
+    ASSERT_TRUE(writer.addHousehold(samples));
+    ASSERT_TRUE(writer.addHousehold({}));
+    const std::vector<uint8_t> file = writer.build();
+
+    const lg::TelemetryView view(file.data(), file.size());
+    ASSERT_TRUE(view.isValid());
+    ASSERT_FALSE(lg::TelemetryView(file.data(), file.size() - 8).isValid());
+    ASSERT_EQ(view.getHouseholdCount(), 2u);
+    ASSERT_EQ(view.getHousehold(1).getSampleCount(), 0u);
+
+    std::vector<lg::ReplaySample> decoded;
+    view.getHousehold(0).forEachSample([&](const lg::ReplaySample& sample) { decoded.push_back(sample); });
+    ASSERT_EQ(decoded.size(), samples.size());
+    for (size_t i = 0; i < samples.size(); i++) {
+        ASSERT_EQ(decoded[i].timestamp, samples[i].timestamp);
+        ASSERT_FLOAT_EQ(decoded[i].flowRate, samples[i].flowRate);
+        ASSERT_EQ(decoded[i].probeId, samples[i].probeId);
+        ASSERT_EQ(decoded[i].probeWet, samples[i].probeWet);
+    }
+}
+
+TEST(TelemetryFileTests, ShouldReplayMappedFile) {
+    std::vector<lg::ReplaySample> samples;
+    for (time_t t = 0; t < 600; t += 10)
+        samples.push_back(lg::ReplaySample { t, t >= 100 ? 3.0f : 0.0f });
+
+    lg::TelemetryWriter writer;
+    writer.addHousehold(samples);
+    const std::string path = testing::TempDir() + "leak_logic_telemetry.bin";
+    ASSERT_TRUE(writer.write(path.c_str()));
+
+    lg::TelemetryFile file;
+    ASSERT_TRUE(file.open(path.c_str()));
+
+    lg::FleetReplay fleet;
+    ASSERT_TRUE(file.addTo(fleet, "T,200,60,|"));
+    const auto events = fleet.run(1);
+    ::unlink(path.c_str());
+
+    ASSERT_EQ(events.size(), 1u);
+    ASSERT_EQ(events[0].timestamp, 150);
+    ASSERT_EQ(events[0].action.getActionReason(), lg::ActionReason::EXCEEDED_FLOW_RATE);
+}
@@ -1,5 +1,14 @@
 #include "suites/leak_logic_tests.hpp"
 #include "suites/serialization_tests.hpp"
+#include "suites/leak_logic_t_tests.hpp"
+#include "suites/flow_rate_batch_tests.hpp"
+#include "suites/fleet_replay_tests.hpp"
+#include "suites/telemetry_file_tests.hpp"
+#include "suites/flow_rate_sweep_tests.hpp"
+#include "suites/flow_episode_index_tests.hpp"
+#include "suites/sample_ring_tests.hpp"
+#include "suites/seqlock_tests.hpp"
+#include "suites/shared_criteria_tests.hpp"
 
 int main(int argc, char **argv)
 {